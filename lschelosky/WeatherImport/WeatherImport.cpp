@@ -20,11 +20,19 @@ using std::fstream;
 void
    WeatherImport::start(
       const string &PORT,
-      const ulong  SPEED
+      const ulong  SPEED,
+      const bool   LOW_LATENCY,
+      const bool   STREAMING,
+      const string &JOURNAL
    )
 {
    LOG_INFO( "Import started." );
-   LOG_INFO( "Opening port " << PORT.c_str() << " @ " << SPEED << " bps." );
+   if( SPEED == 0 )
+      LOG_INFO( "Opening port " << PORT.c_str() << ", detecting the speed." );
+   else
+      LOG_INFO( "Opening port " << PORT.c_str() << " @ " << SPEED << " bps." );
+   _startTick = tickMillis();
+   _firstRecord = false;
 
    /* get the filename. */
    const string DATAM_FILE( getOutputFile() );
@@ -36,32 +44,88 @@ void
 
    /* open the serial port. */
    _serial.setPort( PORT );
-   _serial.setBaudrate( SPEED );
+   _serial.setBaudrate( SPEED ? SPEED : SERIAL_SPEED );
    _serial.setTimeout( _TIMEOUT );
+   _serial.setLowLatency( LOW_LATENCY );
+   /* an adapter reset reopens the port, the loop keeps running. */
+   _serial.setReconnect( Reconnect::backoff( RECONNECT_MILLIS, RECONNECT_MAX_MILLIS ) );
+#if !defined( _WIN32 )
+   /* the station only streams, let the kernel batch each line. */
+   if( STREAMING )
+      _serial.setTransport( serial::transport_streaming );
+#else
+   if( STREAMING )
+      LOG_ERROR( "Streaming is not available on Windows, ignored." );
+#endif
    _serial.open();
    _started = _serial.isOpen();
    if( !_started )
       throw runtime_error( "Can't open the specified port!" );
 
+   /* speed 0, score each candidate rate instead of a TIMEOUT_MILLIS guess. */
+   if( SPEED == 0 )
+   {
+      const uint32_t RATES[] = { AUTOBAUD_RATES };
+      const vector< uint32_t > rates( RATES, RATES + sizeof( RATES ) / sizeof( RATES[0] ) );
+      const uint32_t FOUND( _serial.detectBaudrate( rates, AUTOBAUD_DWELL_MILLIS ) );
+      if( FOUND == 0 )
+         throw runtime_error( "Can't detect the port speed!" );
+      LOG_INFO( "Detected " << FOUND << " bps after " << tickMillis() - _startTick << " ms." );
+   }
+
+   /* every chunk in and out, for a Replay of this session. */
+   if( !JOURNAL.empty() )
+   {
+      _serial.setCapture( JOURNAL );
+      LOG_INFO( "Capturing to " << JOURNAL.c_str() << "." );
+   }
+
    /* wait until available. */
    _serial.synchronize( cout );
+   LOG_INFO( "Serial synchronized after " << tickMillis() - _startTick << " ms." );
+   _statsTick = tickMillis();
+   _lastStats = _serial.getStatistics();
 
-   /* start the communication. */
+#if defined( USE_READER_THREAD )
+   /* the reader thread drains the port, this one parses and writes. */
+   _serial.setTimeout( Timeout::simpleTimeout( READER_TIMEOUT_MILLIS ) );
+   _drops = 0;
+   _reader.start( _serial, RESPONSE_SIZE, RESPONSE_EOL );
+
+   stampedLine line;
    while( !_shutdown )
    {
-      string line( _serial.readline( RESPONSE_SIZE, RESPONSE_EOL ) );
-      const stringVector data( parseNMEA( WIMDA, line ) ) ;
-      if( data.size() )
+      logStatistics();
+      if( _reader.pop( line ) )
       {
-         weatherReport( data );
+         LOG_DEBUG( "queued " << tickMillis() - line.tick << " ms, depth " << _reader.depth() );
+         record( line.text );
+         continue;
+      }
 
+      if( !_reader.running() )
+         throw runtime_error( "The reader thread stopped!" );
+      if( _reader.drops() != _drops )
+      {
+         LOG_ERROR( "Reader queue full, " << _reader.drops() - _drops << " lines dropped!" );
+         _drops = _reader.drops();
+      }
+      xSleep( READER_POLL_MILLIS );
+   }
+#else
+   /* start the communication. */
+   while( !_shutdown )
+   {
+      logStatistics();
+      string line( _serial.readline( RESPONSE_SIZE, RESPONSE_EOL ) );
+      if( record( line ) )
          /* sleep, the serial timeout MUST BE GREATER THAN this delay. */
          xSleep( SLEEP_MILLIS );
-      }
       else
          /* sleep, the serial timeout MUST BE GREATER THAN this delay. */
          xSleep( SMALL_SLEEP_MILLIS );
    }
+#endif
 
    stop();
 }
@@ -72,6 +136,13 @@ void
 {
    if( _started )
    {
+#if defined( USE_READER_THREAD )
+      _reader.stop();
+      LOG_INFO( "Reader: " << _reader.lines() << " lines, "
+         << _reader.highWater() << " queued at most, "
+         << _reader.drops() << " dropped." );
+#endif
+
       if( _ofs.is_open() )
       {
          _ofs.flush();
@@ -104,74 +175,140 @@ const string
    return FOLDER + NAME + EXT;
 }
 
-const stringVector
+void
+   WeatherImport::logStatistics()
+{
+   if( tickMillis() - _statsTick < STATS_MILLIS )
+      return;
+   _statsTick = tickMillis();
+
+   const Statistics STATS( _serial.getStatistics() );
+   const Statistics DELTA( STATS - _lastStats );
+   _lastStats = STATS;
+   LOG_INFO( "Port: " << DELTA.bytes_read << " bytes, "
+      << DELTA.lines << " lines, " << DELTA.partial_lines << " partial, "
+      << DELTA.timeouts << " timeouts." );
+   if( DELTA.hasErrors() || DELTA.brk )
+      LOG_ERROR( "UART: " << DELTA.overrun << " overruns, "
+         << DELTA.frame << " framing, " << DELTA.parity << " parity, "
+         << DELTA.brk << " breaks, " << DELTA.buf_overrun << " buffer overruns!" );
+   if( DELTA.reconnects )
+      LOG_ERROR( "Port lost and reopened " << DELTA.reconnects << " times!" );
+   if( _badChecksums )
+      LOG_ERROR( "NMEA: " << _badChecksums << " sentences with a bad checksum dropped!" );
+   _badChecksums = 0;
+
+   /* the journal stops at its first failed write, say so once. */
+   const int CAPTURE_ERROR( _serial.getCaptureError() );
+   if( CAPTURE_ERROR && CAPTURE_ERROR != _captureError )
+      LOG_ERROR( "Capture stopped, write error " << CAPTURE_ERROR << "!" );
+   _captureError = CAPTURE_ERROR;
+}
+
+const bool
+   WeatherImport::record(
+      string& line
+   )  NOEXCEPTION
+{
+   nmeaFields data;
+   bool decoded( false );
+
+   /* one decoder per sentence id, only WIMDA writes a record. */
+   switch( parseNMEA( line, data ) )
+   {
+   case 0:
+      return false;
+   case NMEA_GPRMC:
+      decoded = nmeaDecode( data, _position );
+      break;
+   case NMEA_GPGSA:
+      decoded = nmeaDecode( data, _satellites );
+      break;
+   case NMEA_HCHDG:
+      decoded = nmeaDecode( data, _heading );
+      break;
+   case NMEA_WIMWV:
+      decoded = nmeaDecode( data, _wind );
+      break;
+   case NMEA_WIMWD:
+      decoded = nmeaDecode( data, _windDir );
+      break;
+   case NMEA_WIMDA:
+      if( !nmeaDecode( data, _weather ) )
+         break;
+      weatherReport( _weather );
+      if( !_firstRecord )
+      {
+         LOG_INFO( "First record after " << tickMillis() - _startTick << " ms." );
+         _firstRecord = true;
+      }
+      return true;
+   default:
+      LOG_DEBUG( "parse NMEA, ignoring unknown sentence!" );
+      return false;
+   }
+
+   if( !decoded )
+      LOG_ERROR( "parse NMEA, invalid column count, ignoring line!" );
+   return false;
+}
+
+const uint64_t
    WeatherImport::parseNMEA(
-      const string& protocol,
-            string& response
+      const string&     response,
+            nmeaFields& data
    )  NOEXCEPTION
 {
-   stringVector data;
+   data.count = 0;
 
    /*
     * Line format:
     * "2016-08-27 10:20\t$WIMDA,30.2269,I,1.0236,B,13.8,C,,,45.9,,2.3,C,80.6,T,69.7,M,1.2,N,0.6,M*53"
-    */
-   removeStr( response, RESPONSE_EOL );
-
-   /*
-    * FIX for the double $ that the device is sending sometimes.
-    * Sample data to test this fix:
+    *
+    * nmeaSentence also takes care of the RESPONSE_EOL and of the double $
+    * that the device is sending sometimes. Sample data to test this fix:
     * "$$GPGSA,A,3,12,5,29,24,21,2,25,20,31,,,,1.7,1.0,1.4*3D"
     */
-   replaceStr( response, "$$", "$" );
+   stringView sentence( nmeaSentence( response ) );
+   if( sentence.empty() )
+   {
+      LOG_ERROR( "parse NMEA, invalid line format!" );
+      return 0;
+   }
 
-   LOG_DEBUG( "response [" << response << "]" );
+   LOG_DEBUG( "response [" << sentence << "]" );
 
-   stringVector sv1( split( response, NMEA_START_DEL ) );
-   if( sv1.size() > 1 )
+   /* a corrupted line never gets near a float conversion. */
+   if( !nmeaVerify( sentence ) )
    {
-      stringVector sv2( split( sv1[1], NMEA_DATA_DEL ) );
-      if( sv2.size() && sv2[0] == protocol )
-      {
-         sv2.erase( sv2.begin() );
-         if( sv2.size() >= 20 )
-            data = sv2;
-         else
-            LOG_ERROR( "parse NMEA, invalid column count, ignoring line!" );
-      }
-      else
-         LOG_DEBUG( "parse NMEA, ignoring protocol [" << sv2[0] << "]" );
+      LOG_DEBUG( "parse NMEA, bad checksum, dropping line!" );
+      _badChecksums ++;
+      return 0;
    }
-   else
-      LOG_ERROR( "parse NMEA, invalid line format!" );
 
-   return data;
+   const size_t ID_END( sentence.find( NMEA_DATA_DEL ) );
+   if( ID_END == stringView::npos
+    || !tokenize( sentence.substr( ID_END + 1 ), data, NMEA_DATA_DEL ) )
+   {
+      LOG_ERROR( "parse NMEA, invalid column count, ignoring line!" );
+      data.count = 0;
+      return 0;
+   }
+   return nmeaId( sentence.substr( 0, ID_END ) );
 }
 
-/*!
- * 30.2239,I,1.0235,B,13.8,C,,,45.9,,2.3,C,73.0,T,62.1,M,1.0,N,0.5,M*53
- * 0       1 2      3 4    5   8    9    11     13     15    17    19
- *                           6       10    12     14     16    18
- *                            7
- */
 void
    WeatherImport::weatherReport(
-      const stringVector& data
+      const nmeaMDA& data
    )  NOEXCEPTION
 {
-   const float barPressBar(    stringTo< float >( data[2],  -999 ) );
-   const float airTemp(        stringTo< float >( data[4],  -999 ) );
-   const float relHumid(       stringTo< float >( data[8],  -999 ) );
-   const float windDegTrue(    stringTo< float >( data[12], -999 ) );
-   const float windSpeedMetre( stringTo< float >( data[18], -999 ) );
-
    _ofs
-      << barPressBar    << ';'
-      << airTemp        << ';'
-      << relHumid       << ';'
-      << windDegTrue    << ';'
-      << windSpeedMetre << ';'
-      << getTimestamp() << REPORT_EOL;
+      << data.barPressBar    << ';'
+      << data.airTemp        << ';'
+      << data.relHumid       << ';'
+      << data.windDegTrue    << ';'
+      << data.windSpeedMetre << ';'
+      << getTimestamp()      << REPORT_EOL;
 }
 
 // -----------------------------------------------------------------------------
@@ -20,6 +20,16 @@
 #define TIMEOUT_MILLIS        10000          /* 10 seconds. */
 #define SLEEP_MILLIS          500
 #define SMALL_SLEEP_MILLIS    200
+#define STATS_MILLIS          60000          /* port statistics log. */
+#define AUTOBAUD_RATES        4800, 9600, 19200, 38400, 57600, 115200   /* -b, most likely first. */
+#define AUTOBAUD_DWELL_MILLIS 1100           /* passive, a sentence a second. */
+#define RECONNECT_MILLIS      50             /* first reopen after a failure, */
+#define RECONNECT_MAX_MILLIS  5000           /* doubling up to this. */
+#define REPLAY_DELAY_MILLIS   500            /* -r, for the port to open. */
+
+#define READER_TIMEOUT_MILLIS 250            /* USE_READER_THREAD only. */
+#define READER_POLL_MILLIS    10
+#define READER_CAPACITY       1024           /* lines! */
 
 #define EOL_CR_C              "\x0D"         /* reference. */
 #define EOL_LF_C              "\x0A"         /* reference. */
@@ -33,16 +43,25 @@
 #define RESPONSE_SIZE         128            /* bytes! */
 #define RESPONSE_EOL          EOL_CR_C
 
-#define WIMDA                 string( "WIMDA" )
-
 #define REPORT_EOL            EOL_CR_LF_C
 
 //-----------------------------------------------------------------------------
 
 #include "xTools/xCommons.h"
 #include "xTools/xSerial.h"
+#include "xTools/xNmea.h"
 using serial::Serial;
 using serial::Timeout;
+using serial::Statistics;
+using serial::Reconnect;
+
+#if defined( USE_READER_THREAD )
+#include "xTools/xLineReader.h"
+#endif
+
+#if defined( USE_SERIAL_LIST ) || defined( USE_SERIAL_ENUM )
+#include "xTools/xProbe.h"
+#endif
 
 #include <fstream>
 using std::ofstream;
@@ -59,7 +78,22 @@ public:
    WeatherImport():
       _shutdown( 0 ),
       _started(  false ),
+      _startTick( 0 ),
+      _firstRecord( false ),
       _serial(   ),
+      _statsTick( 0 ),
+      _lastStats( ),
+      _badChecksums( 0 ),
+      _captureError( 0 ),
+      _position(   ),
+      _satellites( ),
+      _heading(    ),
+      _wind(       ),
+      _windDir(    ),
+      _weather(    ),
+#if defined( USE_READER_THREAD )
+      _reader(   READER_CAPACITY ),
+#endif
       _ofs(      ),
       _TIMEOUT(  Timeout::simpleTimeout( TIMEOUT_MILLIS ) )
    {
@@ -76,12 +110,17 @@ public:
    }
 
    /*!
-    * Start the import.
+    * Start the import, SPEED 0 detects it, LOW_LATENCY asks the driver
+    * for low latency, STREAMING for the streaming transport (unix builds
+    * only), JOURNAL captures the port traffic.
     */
    void
       start(
          const string &PORT,
-         const ulong  SPEED
+         const ulong  SPEED,
+         const bool   LOW_LATENCY = false,
+         const bool   STREAMING = false,
+         const string &JOURNAL = ""
       );
 
    /*!
@@ -91,6 +130,16 @@ public:
       stop()
          NOEXCEPTION;
 
+   /*!
+    * The last sentence of each kind decoded, zeroed until the first.
+    */
+   const nmeaRMC& position()   const { return _position; }
+   const nmeaGSA& satellites() const { return _satellites; }
+   const nmeaHDG& heading()    const { return _heading; }
+   const nmeaMWV& wind()       const { return _wind; }
+   const nmeaMWD& windDir()    const { return _windDir; }
+   const nmeaMDA& weather()    const { return _weather; }
+
 private:
 
    /*!
@@ -100,12 +149,29 @@ private:
       getOutputFile();
 
    /*!
-    * Parse the NMEA string.
+    * Log the port statistics since the last log, every STATS_MILLIS.
+    */
+   void
+      logStatistics();
+
+   /*!
+    * Parse one line and write its record, true when written.
+    */
+   const bool
+      record(
+         string& line
+      )  NOEXCEPTION;
+
+   /*!
+    * Parse the NMEA string, the fields after the id into data. The
+    * fields are views over response.
+    *
+    * \return the NMEA_ID of the sentence, 0 for a bad line.
     */
-   const stringVector
+   const uint64_t
       parseNMEA(
-      const string& protocol,
-            string& response
+      const string&     response,
+            nmeaFields& data
       )  NOEXCEPTION;
 
    /*!
@@ -113,13 +179,29 @@ private:
     */
    void
       weatherReport(
-      const stringVector& data
+      const nmeaMDA& data
       )  NOEXCEPTION;
 
 private:
    int       _shutdown;
    bool      _started;
+   ulong     _startTick;       /* tickMillis at start, for the log. */
+   bool      _firstRecord;     /* first record already logged. */
    Serial    _serial;
+   ulong     _statsTick;       /* tickMillis of the last statistics log. */
+   Statistics _lastStats;      /* port statistics at that log. */
+   ulong     _badChecksums;    /* sentences dropped since that log. */
+   int       _captureError;    /* journal errno already logged. */
+   nmeaRMC   _position;        /* the last of each sentence. */
+   nmeaGSA   _satellites;
+   nmeaHDG   _heading;
+   nmeaMWV   _wind;
+   nmeaMWD   _windDir;
+   nmeaMDA   _weather;
+#if defined( USE_READER_THREAD )
+   LineReader _reader;         /* drains _serial on its own thread. */
+   ulong     _drops;           /* _reader drops already logged. */
+#endif
    ofstream  _ofs;
 
    const
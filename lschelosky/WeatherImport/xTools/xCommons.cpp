@@ -15,8 +15,11 @@
 #pragma warning( disable : 4800 )
 
 #include "xCommons.h"
+#include "v8stdint.h"
 
 #include <iostream>
+#include <limits>
+#include <cctype>
 
 #include <sstream>
 using std::stringstream;
@@ -205,6 +208,154 @@ namespace xTools
       Sleep( millis );           /* 100 ms. */
    }
 
+   const ulong
+      tickMillis()
+         NOEXCEPTION
+   {
+#ifdef _WIN32
+      return GetTickCount();
+#else
+      struct timespec ts;
+      clock_gettime( CLOCK_MONOTONIC, &ts );
+      return ts.tv_sec * 1000UL + ts.tv_nsec / 1000000UL;
+#endif
+   }
+
+   /* outcome of scanDecimal. */
+   enum
+   {
+      SCAN_NONE,                 /* not a number. */
+      SCAN_FAST,                 /* scanned, exact. */
+      SCAN_SLOW                  /* leave it to the stream. */
+   };
+
+   /* [blanks][sign]digits[.digits], what NMEA and the devices send. */
+   struct decimalScan
+   {
+      bool     negative;
+      uint64_t mantissa;         /* all the digits, the point dropped. */
+      int      scale;            /* digits after the point. */
+   };
+
+   /*
+    * Scan a decimal at the start of STR, the fraction only if FRACTION.
+    * Exponents and mantissas beyond 64 bits are SCAN_SLOW.
+    */
+   static
+   const int
+      scanDecimal(
+      const stringView& STR,
+      const bool        FRACTION,
+            decimalScan& out
+      )
+   {
+      static const uint64_t MANTISSA_MAX( ( ~static_cast< uint64_t >( 0 ) - 9 ) / 10 );
+
+      const char* it( STR.data() );
+      const char* const END( it + STR.size() );
+      while( it != END && isspace( static_cast< uchar >( *it ) ) )
+         ++ it;
+
+      out.negative = false;
+      out.mantissa = 0;
+      out.scale    = 0;
+      if( it != END && ( *it == '-' || *it == '+' ) )
+         out.negative = *it ++ == '-';
+
+      int digits( 0 );
+      for( ; it != END && *it >= '0' && *it <= '9'; ++ it, ++ digits )
+      {
+         if( out.mantissa > MANTISSA_MAX )
+            return SCAN_SLOW;
+         out.mantissa = out.mantissa * 10 + ( *it - '0' );
+      }
+      if( FRACTION && it != END && *it == '.' )
+      {
+         for( ++ it; it != END && *it >= '0' && *it <= '9'; ++ it, ++ digits, ++ out.scale )
+         {
+            if( out.mantissa > MANTISSA_MAX )
+               return SCAN_SLOW;
+            out.mantissa = out.mantissa * 10 + ( *it - '0' );
+         }
+      }
+      if( !digits )
+         return SCAN_NONE;
+      if( FRACTION && it != END && ( *it == 'e' || *it == 'E' ) )
+         return SCAN_SLOW;
+      return SCAN_FAST;
+   }
+
+   /* T in range, else the stream decides. */
+   template< typename T >
+   static
+   const bool
+      parseInteger(
+      const stringView& STR,
+            T&          val
+      )
+   {
+      decimalScan scan;
+      const int SCAN( scanDecimal( STR, false, scan ) );
+      if( SCAN == SCAN_NONE )
+         return false;
+
+      if( SCAN == SCAN_FAST && !scan.negative && scan.mantissa <= static_cast< uint64_t >( std::numeric_limits< T >::max() ) )
+      {
+         val = static_cast< T >( scan.mantissa );
+         return true;
+      }
+      if( SCAN == SCAN_FAST && scan.negative && std::numeric_limits< T >::is_signed
+       && scan.mantissa <= static_cast< uint64_t >( std::numeric_limits< T >::max() ) + 1 )
+      {
+         /* two's complement, so the magnitude of min() fits too. */
+         val = static_cast< T >( 0 - scan.mantissa );
+         return true;
+      }
+      return streamNumber( STR, val );
+   }
+
+   /*
+    * T when the conversion is exact, MANTISSA_BITS and powers of ten up
+    * to MAX_SCALE both representable, else the stream decides.
+    */
+   template< typename T >
+   static
+   const bool
+      parseFloat(
+      const stringView& STR,
+            T&          val,
+      const int         MANTISSA_BITS,
+      const int         MAX_SCALE
+      )
+   {
+      static const double POW10[] =
+      {
+         1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+         1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+      };
+
+      decimalScan scan;
+      const int SCAN( scanDecimal( STR, true, scan ) );
+      if( SCAN == SCAN_NONE )
+         return false;
+
+      if( SCAN == SCAN_FAST && ( scan.mantissa >> MANTISSA_BITS ) == 0 && scan.scale <= MAX_SCALE )
+      {
+         /* one correctly rounded division, also for float through double. */
+         const double VALUE( static_cast< double >( static_cast< int64_t >( scan.mantissa ) ) / POW10[ scan.scale ] );
+         val = static_cast< T >( scan.negative ? -VALUE : VALUE );
+         return true;
+      }
+      return streamNumber( STR, val );
+   }
+
+   const bool parseNumber( const stringView& STR, int&    val ) NOEXCEPTION { return parseInteger( STR, val ); }
+   const bool parseNumber( const stringView& STR, long&   val ) NOEXCEPTION { return parseInteger( STR, val ); }
+   const bool parseNumber( const stringView& STR, uint&   val ) NOEXCEPTION { return parseInteger( STR, val ); }
+   const bool parseNumber( const stringView& STR, ulong&  val ) NOEXCEPTION { return parseInteger( STR, val ); }
+   const bool parseNumber( const stringView& STR, float&  val ) NOEXCEPTION { return parseFloat( STR, val, 24, 10 ); }
+   const bool parseNumber( const stringView& STR, double& val ) NOEXCEPTION { return parseFloat( STR, val, 53, 22 ); }
+
    const bool split( const string& STR, stringVector& out, const char DEL, const uint& MIN ) NOEXCEPTION
    {
       stringstream ss( STR );
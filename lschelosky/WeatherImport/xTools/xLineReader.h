@@ -0,0 +1,164 @@
+/*!
+** \file    xLineReader.h
+** \date    2026/10/17 08:00
+** \brief   xTools serial reader thread with a lock-free line queue, definition.
+** \author  A.Godinho (Woody)
+**/
+
+#ifndef __XTOOLS_XLINEREADER_H__
+#define __XTOOLS_XLINEREADER_H__
+
+//-----------------------------------------------------------------------------
+
+#include "xCommons.h"
+#include "xSerial.h"
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+//-----------------------------------------------------------------------------
+
+namespace xTools
+{
+   /*!
+    * Line read from the port, with the tickMillis it was read at.
+    */
+   struct stampedLine
+   {
+      ulong    tick;
+      string   text;
+   };
+
+   /*!
+    * Reader thread that only drains a serial port, line by line, into a
+    * lock-free single producer, single consumer ring of stamped lines.
+    * The importer thread pops, parses and writes at its own pace, a slow
+    * disk or log never holds back the next readline.
+    *
+    * The reader never waits for room: with the ring full the line is
+    * dropped and counted, the UART FIFO is what must not overrun.
+    */
+   class LineReader
+   {
+   public:
+
+      /*!
+       * Constructor, CAPACITY is rounded up to a power of two.
+       */
+      explicit
+      LineReader(
+         const size_t CAPACITY = 1024
+      );
+
+      /*!
+       * Destructor, stops the reader.
+       */
+      ~LineReader();
+
+      /*!
+       * Start reading lines from PORT, open already. The reader checks
+       * for stop between reads, keep the port read timeout short.
+       */
+      void
+         start(
+            serial::Serial& port,
+            const size_t    SIZE,
+            const string&   EOL
+         );
+
+      /*!
+       * Stop the reader, returns once its current read does.
+       */
+      void
+         stop()
+            NOEXCEPTION;
+
+      /*!
+       * Take the oldest line, false when none is queued. Consumer only.
+       */
+      const bool
+         pop(
+            stampedLine& line
+         )  NOEXCEPTION;
+
+      /*! Lines queued now. */
+      const size_t
+         depth() const
+            NOEXCEPTION;
+
+      /*! Most lines ever queued at once. */
+      const size_t
+         highWater() const
+            NOEXCEPTION;
+
+      /*! Lines read so far, dropped ones included. */
+      const ulong
+         lines() const
+            NOEXCEPTION;
+
+      /*! Lines dropped because the ring was full. */
+      const ulong
+         drops() const
+            NOEXCEPTION;
+
+      /*! False once the reader quit, on stop or on a port error. */
+      const bool
+         running() const
+            NOEXCEPTION;
+
+   private:
+      /* Disable copy constructors. */
+      LineReader( const LineReader& );
+      LineReader& operator = ( const LineReader& );
+
+      friend struct LineReaderThread;
+
+      /* Reader thread body. */
+      void
+         loop();
+
+      /* Queue text, leaves it empty, producer only. */
+      void
+         push(
+            string& text
+         )  NOEXCEPTION;
+
+      vector< stampedLine > _ring;
+      const size_t          _MASK;
+
+      /* Written by the reader only. */
+      volatile size_t       _head;
+      volatile size_t       _highWater;
+      volatile ulong        _lines;
+      volatile ulong        _drops;
+      volatile bool         _running;
+
+      /* Written by the importer only. */
+      volatile size_t       _tail;
+      volatile bool         _stop;
+
+      serial::Serial*       _port;
+      size_t                _size;
+      string                _eol;
+      string                _partial;   /* line cut by a read timeout. */
+
+#ifdef _WIN32
+      void*                 _thread;
+#else
+      pthread_t             _thread;
+#endif
+      bool                  _started;
+   };
+}
+
+//-----------------------------------------------------------------------------
+
+using xTools::stampedLine;
+using xTools::LineReader;
+
+#endif /* __XTOOLS_XLINEREADER_H__ */
+
+//-----------------------------------------------------------------------------
+
+// EOF.
@@ -0,0 +1,139 @@
+/*!
+** \file    xNmea.cpp
+** \date    2026/10/17 08:00
+** \brief   xTools NMEA 0183 sentence tokenizer, implementation.
+** \author  A.Godinho (Woody)
+**/
+
+#include "xNmea.h"
+
+#include <cstring>
+
+//-----------------------------------------------------------------------------
+
+namespace xTools
+{
+   /* value of one hex digit, -1 if not one. */
+   static
+   const int
+      hexValue(
+      const char CC
+      )
+   {
+      if( CC >= '0' && CC <= '9' )
+         return CC - '0';
+      if( CC >= 'A' && CC <= 'F' )
+         return CC - 'A' + 10;
+      if( CC >= 'a' && CC <= 'f' )
+         return CC - 'a' + 10;
+      return -1;
+   }
+
+   const stringView
+      nmeaSentence(
+      const stringView& LINE
+      )  NOEXCEPTION
+   {
+      const char* it( LINE.data() );
+      const char* const END( it + LINE.size() );
+
+      while( it != END && *it != '$' )
+         ++ it;
+      if( it == END )
+         return stringView();
+      while( it != END && *it == '$' )
+         ++ it;
+
+      const char* const START( it );
+      while( it != END && *it != '$' && *it != '\r' && *it != '\n' )
+         ++ it;
+      return stringView( START, it - START );
+   }
+
+   const uint8_t
+      nmeaChecksum(
+      const stringView& BODY
+      )  NOEXCEPTION
+   {
+      const char* it( BODY.data() );
+      size_t n( BODY.size() );
+
+      /* XOR is bytewise, so fold whole words and then their bytes. */
+      uint64_t word( 0 );
+      for( ; n >= sizeof( word ); n -= sizeof( word ), it += sizeof( word ) )
+      {
+         uint64_t chunk;
+         memcpy( &chunk, it, sizeof( chunk ) );
+         word ^= chunk;
+      }
+      word ^= word >> 32;
+      word ^= word >> 16;
+      word ^= word >> 8;
+
+      uint8_t sum( static_cast< uint8_t >( word ) );
+      for( ; n; -- n, ++ it )
+         sum ^= static_cast< uint8_t >( *it );
+      return sum;
+   }
+
+   const bool
+      nmeaVerify(
+            stringView& sentence
+      )  NOEXCEPTION
+   {
+      const size_t SIZE( sentence.size() );
+      if( SIZE < 3 || sentence[ SIZE - 3 ] != '*' )
+         return false;
+
+      const int HI( hexValue( sentence[ SIZE - 2 ] ) );
+      const int LO( hexValue( sentence[ SIZE - 1 ] ) );
+      if( HI < 0 || LO < 0 )
+         return false;
+
+      const stringView BODY( sentence.substr( 0, SIZE - 3 ) );
+      if( nmeaChecksum( BODY ) != ( HI << 4 | LO ) )
+         return false;
+
+      sentence = BODY;
+      return true;
+   }
+
+   const uint64_t
+      nmeaId(
+      const stringView& ID
+      )  NOEXCEPTION
+   {
+      if( ID.size() != 5 )
+         return 0;
+      return NMEA_ID( ID[ 0 ], ID[ 1 ], ID[ 2 ], ID[ 3 ], ID[ 4 ] );
+   }
+
+   const bool
+      tokenize(
+      const stringView& LINE,
+            nmeaFields& out,
+      const char        DEL
+      )  NOEXCEPTION
+   {
+      const char* it( LINE.data() );
+      const char* const END( it + LINE.size() );
+
+      out.count = 0;
+      for( ;; )
+      {
+         if( out.count == nmeaFields::CAPACITY )
+            return false;
+
+         const char* const START( it );
+         while( it != END && *it != DEL )
+            ++ it;
+         out.field[ out.count ++ ] = stringView( START, it - START );
+
+         if( it == END )
+            return true;
+         ++ it;
+      }
+   }
+}
+
+// EOF.
@@ -0,0 +1,503 @@
+/*!
+** \file    xNmea.h
+** \date    2026/10/17 08:00
+** \brief   xTools NMEA 0183 sentence tokenizer and decoders, definition.
+** \author  A.Godinho (Woody)
+**/
+
+#ifndef __XTOOLS_XNMEA_H__
+#define __XTOOLS_XNMEA_H__
+
+//-----------------------------------------------------------------------------
+
+#include "xTypes.h"
+#include "v8stdint.h"
+#include "xStringView.h"
+#include "xCommons.h"
+
+//-----------------------------------------------------------------------------
+
+/*!
+** The 5 character talker and sentence id packed in an integer, a switch
+** case label. See nmeaId.
+** ----------------------------------------------------------------------------
+**/
+#define NMEA_ID( A, B, C, D, E )                   \
+   ( ( uint64_t )( uchar )( A ) << 32              \
+   | ( uint64_t )( uchar )( B ) << 24              \
+   | ( uint64_t )( uchar )( C ) << 16              \
+   | ( uint64_t )( uchar )( D ) << 8               \
+   | ( uint64_t )( uchar )( E ) )
+
+#define NMEA_GPRMC            NMEA_ID( 'G', 'P', 'R', 'M', 'C' )   /* position, course, speed. */
+#define NMEA_GPGSA            NMEA_ID( 'G', 'P', 'G', 'S', 'A' )   /* fix and satellites. */
+#define NMEA_HCHDG            NMEA_ID( 'H', 'C', 'H', 'D', 'G' )   /* compass heading. */
+#define NMEA_WIMWV            NMEA_ID( 'W', 'I', 'M', 'W', 'V' )   /* wind speed and angle. */
+#define NMEA_WIMWD            NMEA_ID( 'W', 'I', 'M', 'W', 'D' )   /* wind direction and speed. */
+#define NMEA_WIMDA            NMEA_ID( 'W', 'I', 'M', 'D', 'A' )   /* meteorological composite. */
+
+#define NMEA_NO_VALUE         -999           /* an empty or bad field. */
+
+//-----------------------------------------------------------------------------
+
+namespace xTools
+{
+   /*!
+    * The fields of one sentence, as views over the tokenized line; no
+    * copies and no allocation. The line MUST outlive the fields.
+    */
+   struct nmeaFields
+   {
+      /* an 82 character sentence can't hold more. */
+      enum { CAPACITY = 40 };
+
+      stringView  field[ CAPACITY ];
+      size_t      count;
+
+      nmeaFields():
+         count( 0 )
+      {
+         /* Nothing. */
+      }
+
+      const stringView&
+         operator[]( const size_t I ) const
+      {
+         return field[ I ];
+      }
+
+      const size_t   size()  const { return count; }
+      const bool     empty() const { return count == 0; }
+   };
+
+   /*!
+    * The sentence within a received line, from after the first '$' up
+    * to the next '$' or line end. A doubled "$$", that the station
+    * sends sometimes, counts as one.
+    *
+    * \return empty when LINE holds no '$'.
+    */
+   const stringView
+      nmeaSentence(
+      const stringView& LINE
+      )  NOEXCEPTION;
+
+   /*!
+    * The NMEA checksum of BODY, the XOR of all its characters. Works a
+    * 64 bit word at a time, for replays at full speed.
+    */
+   const uint8_t
+      nmeaChecksum(
+      const stringView& BODY
+      )  NOEXCEPTION;
+
+   /*!
+    * Check the "*hh" checksum that ends sentence, as given by
+    * nmeaSentence, and strip it.
+    *
+    * \return false when missing or wrong, sentence then unchanged.
+    */
+   const bool
+      nmeaVerify(
+            stringView& sentence
+      )  NOEXCEPTION;
+
+   /*!
+    * The packed NMEA_ID of a 5 character id, 0 for any other length.
+    */
+   const uint64_t
+      nmeaId(
+      const stringView& ID
+      )  NOEXCEPTION;
+
+   /*!
+    * Split LINE at every DEL into out, empty fields (",,") kept as
+    * empty views.
+    *
+    * \return false when LINE has more than CAPACITY fields, out then
+    *         holds the first CAPACITY.
+    */
+   const bool
+      tokenize(
+      const stringView& LINE,
+            nmeaFields& out,
+      const char        DEL = ','
+      )  NOEXCEPTION;
+
+   /*!
+    * Decoded sentences, the fields after the id; see their nmeaSchema
+    * for columns and units. NMEA_NO_VALUE or '\0' when not sent.
+    */
+
+   /* $GPRMC, recommended minimum GNSS data. */
+   struct nmeaRMC
+   {
+      double   time;
+      char     status;        /* 'A' valid, 'V' warning. */
+      double   latitude;      /* south negative. */
+      double   longitude;     /* west negative. */
+      float    speedKnots;
+      float    courseTrue;
+      ulong    date;
+      float    variation;     /* west negative. */
+   };
+
+   /* $GPGSA, fix mode and the satellites in use. */
+   struct nmeaGSA
+   {
+      char     mode;          /* 'A' automatic, 'M' manual. */
+      int      fix;           /* 1 none, 2 2D, 3 3D. */
+      int      prn[ 12 ];
+      float    pdop;
+      float    hdop;
+      float    vdop;
+   };
+
+   /* $HCHDG, magnetic heading. */
+   struct nmeaHDG
+   {
+      float    heading;
+      float    deviation;     /* west negative. */
+      float    variation;     /* west negative. */
+   };
+
+   /* $WIMWV, wind angle and speed. */
+   struct nmeaMWV
+   {
+      float    angle;
+      char     reference;     /* 'R' relative, 'T' true. */
+      float    speed;
+      char     unit;          /* 'K' km/h, 'M' m/s, 'N' knots. */
+      char     status;        /* 'A' valid. */
+   };
+
+   /* $WIMWD, wind direction and speed. */
+   struct nmeaMWD
+   {
+      float    directionTrue;
+      float    directionMag;
+      float    speedKnots;
+      float    speedMetre;
+   };
+
+   /* $WIMDA, meteorological composite. */
+   struct nmeaMDA
+   {
+      float    barPressInch;
+      float    barPressBar;
+      float    airTemp;
+      float    waterTemp;
+      float    relHumid;
+      float    absHumid;
+      float    dewPoint;
+      float    windDegTrue;
+      float    windDegMag;
+      float    windSpeedKnots;
+      float    windSpeedMetre;
+   };
+
+   /*!
+    * Field kinds, how the columns of a field become a member of type
+    * KIND::type. WIDTH is the number of columns read, decode reads
+    * them from COLUMN on.
+    */
+
+   /* a number, NMEA_NO_VALUE when empty or bad. */
+   template< typename T >
+   struct nmeaNumber
+   {
+      typedef T type;
+      enum { WIDTH = 1 };
+
+      static void
+         decode( const stringView* COLUMN, T& out )
+      {
+         out = stringTo< T >( COLUMN[0], static_cast< T >( NMEA_NO_VALUE ) );
+      }
+   };
+
+   /* a whole number, 0 when empty or bad. */
+   template< typename T >
+   struct nmeaCount
+   {
+      typedef T type;
+      enum { WIDTH = 1 };
+
+      static void
+         decode( const stringView* COLUMN, T& out )
+      {
+         out = stringTo< T >( COLUMN[0], 0 );
+      }
+   };
+
+   /* a one letter flag, '\0' when empty. */
+   struct nmeaLetter
+   {
+      typedef char type;
+      enum { WIDTH = 1 };
+
+      static void
+         decode( const stringView* COLUMN, char& out )
+      {
+         out = COLUMN[0].empty() ? '\0' : COLUMN[0][0];
+      }
+   };
+
+   /* a number and its direction letter, negated for NEGATIVE. */
+   template< typename T, char NEGATIVE >
+   struct nmeaSigned
+   {
+      typedef T type;
+      enum { WIDTH = 2 };
+
+      static void
+         decode( const stringView* COLUMN, T& out )
+      {
+         nmeaNumber< T >::decode( COLUMN, out );
+         if( out != NMEA_NO_VALUE && !COLUMN[1].empty() && COLUMN[1][0] == NEGATIVE )
+            out = -out;
+      }
+   };
+
+   /* [d]ddmm.mmmm and its hemisphere, in degrees, negated for NEGATIVE. */
+   template< char NEGATIVE >
+   struct nmeaDegrees
+   {
+      typedef double type;
+      enum { WIDTH = 2 };
+
+      static void
+         decode( const stringView* COLUMN, double& out )
+      {
+         nmeaSigned< double, NEGATIVE >::decode( COLUMN, out );
+         if( out != NMEA_NO_VALUE )
+         {
+            const double DEG( static_cast< int >( out / 100 ) );
+            out = DEG + ( out - DEG * 100 ) / 60;
+         }
+      }
+   };
+
+   /* N fields of KIND in a row, into an array. */
+   template< typename KIND, size_t N >
+   struct nmeaList
+   {
+      typedef typename KIND::type type[ N ];
+      enum { WIDTH = KIND::WIDTH * N };
+
+      static void
+         decode( const stringView* COLUMN, type& out )
+      {
+         for( size_t i( 0 ); i < N; i ++ )
+            KIND::decode( COLUMN + i * KIND::WIDTH, out[ i ] );
+      }
+   };
+
+   /*!
+    * The schema of sentence S: COLUMNS, the fields after the id that it
+    * needs, and fields(), every member with its column and kind, given
+    * to a decoder. A sentence without a schema doesn't compile.
+    */
+   template< typename S >
+   struct nmeaSchema;
+
+   /*!
+    * Fills S from the fields, one member per field() of its schema. A
+    * member of another type than its kind, or a field past COLUMNS,
+    * doesn't compile.
+    */
+   template< typename S >
+   class nmeaDecoder
+   {
+   public:
+      nmeaDecoder(
+         const nmeaFields& FIELDS,
+               S&          out
+      ):
+         _fields( FIELDS ),
+         _out(    out )
+      {
+         /* Nothing. */
+      }
+
+      template< size_t COLUMN, typename KIND >
+      void
+         field( typename KIND::type S::* member )
+      {
+         /* a negative array size here, the field reads past COLUMNS. */
+         enum { FIELD_FITS_SCHEMA = sizeof( char[
+            COLUMN + KIND::WIDTH <= static_cast< size_t >( nmeaSchema< S >::COLUMNS ) ? 1 : -1 ] ) };
+         KIND::decode( &_fields.field[ COLUMN ], _out.*member );
+      }
+
+   private:
+      const nmeaFields& _fields;
+            S&          _out;
+   };
+
+   template<>
+   struct nmeaSchema< nmeaRMC >
+   {
+      /* 055936.40,A,2823.0122,S,15018.3935,E,1.3,330.1,020317,10.4,E,A */
+      enum { COLUMNS = 11 };
+
+      template< typename D >
+      static void
+         fields( D& d )
+      {
+         d.template field< 0,  nmeaNumber< double >       >( &nmeaRMC::time );        /* hhmmss.ss UTC. */
+         d.template field< 1,  nmeaLetter                 >( &nmeaRMC::status );
+         d.template field< 2,  nmeaDegrees< 'S' >         >( &nmeaRMC::latitude );    /* degrees. */
+         d.template field< 4,  nmeaDegrees< 'W' >         >( &nmeaRMC::longitude );   /* degrees. */
+         d.template field< 6,  nmeaNumber< float >        >( &nmeaRMC::speedKnots );  /* knots. */
+         d.template field< 7,  nmeaNumber< float >        >( &nmeaRMC::courseTrue );  /* degrees. */
+         d.template field< 8,  nmeaCount< ulong >         >( &nmeaRMC::date );        /* ddmmyy. */
+         d.template field< 9,  nmeaSigned< float, 'W' >   >( &nmeaRMC::variation );   /* degrees. */
+      }
+   };
+
+   template<>
+   struct nmeaSchema< nmeaGSA >
+   {
+      /* A,3,12,5,29,24,21,2,25,20,31,,,,1.7,1.0,1.4 */
+      enum { COLUMNS = 17 };
+
+      template< typename D >
+      static void
+         fields( D& d )
+      {
+         d.template field< 0,  nmeaLetter                      >( &nmeaGSA::mode );
+         d.template field< 1,  nmeaNumber< int >               >( &nmeaGSA::fix );
+         d.template field< 2,  nmeaList< nmeaCount< int >, 12 > >( &nmeaGSA::prn );    /* 0, no satellite. */
+         d.template field< 14, nmeaNumber< float >             >( &nmeaGSA::pdop );
+         d.template field< 15, nmeaNumber< float >             >( &nmeaGSA::hdop );
+         d.template field< 16, nmeaNumber< float >             >( &nmeaGSA::vdop );
+      }
+   };
+
+   template<>
+   struct nmeaSchema< nmeaHDG >
+   {
+      /* 345.3,0.0,E,10.4,E */
+      enum { COLUMNS = 5 };
+
+      template< typename D >
+      static void
+         fields( D& d )
+      {
+         d.template field< 0,  nmeaNumber< float >        >( &nmeaHDG::heading );     /* degrees magnetic. */
+         d.template field< 1,  nmeaSigned< float, 'W' >   >( &nmeaHDG::deviation );   /* degrees. */
+         d.template field< 3,  nmeaSigned< float, 'W' >   >( &nmeaHDG::variation );   /* degrees. */
+      }
+   };
+
+   template<>
+   struct nmeaSchema< nmeaMWV >
+   {
+      /* 254.3,R,0.9,N,A */
+      enum { COLUMNS = 5 };
+
+      template< typename D >
+      static void
+         fields( D& d )
+      {
+         d.template field< 0,  nmeaNumber< float >        >( &nmeaMWV::angle );       /* degrees. */
+         d.template field< 1,  nmeaLetter                 >( &nmeaMWV::reference );
+         d.template field< 2,  nmeaNumber< float >        >( &nmeaMWV::speed );       /* in unit. */
+         d.template field< 3,  nmeaLetter                 >( &nmeaMWV::unit );
+         d.template field< 4,  nmeaLetter                 >( &nmeaMWV::status );
+      }
+   };
+
+   template<>
+   struct nmeaSchema< nmeaMWD >
+   {
+      /* 257.8,T,247.4,M,2.1,N,1.1,M */
+      enum { COLUMNS = 8 };
+
+      template< typename D >
+      static void
+         fields( D& d )
+      {
+         d.template field< 0,  nmeaNumber< float >        >( &nmeaMWD::directionTrue );  /* degrees true, T. */
+         d.template field< 2,  nmeaNumber< float >        >( &nmeaMWD::directionMag );   /* degrees magnetic, M. */
+         d.template field< 4,  nmeaNumber< float >        >( &nmeaMWD::speedKnots );     /* knots, N. */
+         d.template field< 6,  nmeaNumber< float >        >( &nmeaMWD::speedMetre );     /* m/s, M. */
+      }
+   };
+
+   template<>
+   struct nmeaSchema< nmeaMDA >
+   {
+      /* 30.2239,I,1.0235,B,13.8,C,,,45.9,,2.3,C,73.0,T,62.1,M,1.0,N,0.5,M */
+      enum { COLUMNS = 20 };
+
+      template< typename D >
+      static void
+         fields( D& d )
+      {
+         d.template field< 0,  nmeaNumber< float >        >( &nmeaMDA::barPressInch );   /* inches of mercury, I. */
+         d.template field< 2,  nmeaNumber< float >        >( &nmeaMDA::barPressBar );    /* bars, B. */
+         d.template field< 4,  nmeaNumber< float >        >( &nmeaMDA::airTemp );        /* celsius, C. */
+         d.template field< 6,  nmeaNumber< float >        >( &nmeaMDA::waterTemp );      /* celsius, C. */
+         d.template field< 8,  nmeaNumber< float >        >( &nmeaMDA::relHumid );       /* percent. */
+         d.template field< 9,  nmeaNumber< float >        >( &nmeaMDA::absHumid );       /* percent. */
+         d.template field< 10, nmeaNumber< float >        >( &nmeaMDA::dewPoint );       /* celsius, C. */
+         d.template field< 12, nmeaNumber< float >        >( &nmeaMDA::windDegTrue );    /* degrees true, T. */
+         d.template field< 14, nmeaNumber< float >        >( &nmeaMDA::windDegMag );     /* degrees magnetic, M. */
+         d.template field< 16, nmeaNumber< float >        >( &nmeaMDA::windSpeedKnots ); /* knots, N. */
+         d.template field< 18, nmeaNumber< float >        >( &nmeaMDA::windSpeedMetre ); /* m/s, M. */
+      }
+   };
+
+   /*!
+    * Decode the fields after the id into out, through its schema; only
+    * the columns the schema names are converted.
+    *
+    * \return false when there are fewer than COLUMNS fields, out then
+    *         unchanged.
+    */
+   template< typename S >
+   const bool
+      nmeaDecode(
+      const nmeaFields& FIELDS,
+            S&          out
+      )  NOEXCEPTION
+   {
+      if( FIELDS.size() < static_cast< size_t >( nmeaSchema< S >::COLUMNS ) )
+         return false;
+
+      nmeaDecoder< S > decoder( FIELDS, out );
+      nmeaSchema< S >::fields( decoder );
+      return true;
+   }
+}
+
+//-----------------------------------------------------------------------------
+
+using xTools::nmeaFields;
+using xTools::nmeaSentence;
+using xTools::nmeaChecksum;
+using xTools::nmeaVerify;
+using xTools::nmeaId;
+using xTools::tokenize;
+using xTools::nmeaRMC;
+using xTools::nmeaGSA;
+using xTools::nmeaHDG;
+using xTools::nmeaMWV;
+using xTools::nmeaMWD;
+using xTools::nmeaMDA;
+using xTools::nmeaNumber;
+using xTools::nmeaCount;
+using xTools::nmeaLetter;
+using xTools::nmeaSigned;
+using xTools::nmeaDegrees;
+using xTools::nmeaList;
+using xTools::nmeaSchema;
+using xTools::nmeaDecode;
+
+#endif /* __XTOOLS_XNMEA_H__ */
+
+//-----------------------------------------------------------------------------
+
+// EOF.
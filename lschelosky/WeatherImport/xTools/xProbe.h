@@ -0,0 +1,77 @@
+/*!
+** \file    xProbe.h
+** \date    2026/10/17 08:00
+** \brief   xTools concurrent serial port probe, definition.
+** \author  A.Godinho (Woody)
+**/
+
+#ifndef __XTOOLS_XPROBE_H__
+#define __XTOOLS_XPROBE_H__
+
+//-----------------------------------------------------------------------------
+
+#include "xCommons.h"
+#include "xSerial.h"
+
+//-----------------------------------------------------------------------------
+
+namespace xTools
+{
+   /*!
+    * One kind of device a port may carry, and how to tell.
+    */
+   struct probeSpec
+   {
+      string   name;       /* device type, the key of the mapping. */
+      ulong    baudrate;
+      string   request;    /* written once at open, empty to only sniff. */
+      string   match;      /* a line holding this identifies the device. */
+      string   eol;
+      ulong    millis;     /* dwell, from open to giving up. */
+
+      probeSpec(
+         const string& NAME,
+         const ulong   BAUDRATE,
+         const string& REQUEST,
+         const string& MATCH,
+         const string& EOL,
+         const ulong   MILLIS
+      ):
+         name(     NAME ),
+         baudrate( BAUDRATE ),
+         request(  REQUEST ),
+         match(    MATCH ),
+         eol(      EOL ),
+         millis(   MILLIS )
+      {
+         /* Nothing. */
+      }
+   };
+
+   /*!
+    * Probe all PORTS at once, one thread each. Every port tries SPECS
+    * in order, active probes first is best, and stops at the first
+    * match; ports that fail to open are skipped.
+    *
+    * The whole probe takes about the longest sum of dwells, however
+    * many ports there are.
+    *
+    * \return device name to port, for the devices found.
+    */
+   const stringMap
+      probePorts(
+         const stringVector&          PORTS,
+         const vector< probeSpec >&   SPECS
+      );
+}
+
+//-----------------------------------------------------------------------------
+
+using xTools::probeSpec;
+using xTools::probePorts;
+
+#endif /* __XTOOLS_XPROBE_H__ */
+
+//-----------------------------------------------------------------------------
+
+// EOF.
@@ -0,0 +1,263 @@
+/*!
+** \file    xScan.cpp
+** \date    2026/10/17 08:00
+** \brief   xTools vectorized EOL and delimiter scanner, implementation.
+** \author  A.Godinho (Woody)
+**
+** All kernels share one idea: compare a block against the first EOL
+** byte, the block EOL_LEN - 1 bytes further against the last EOL byte,
+** and only confirm the middle bytes where both hit. Every candidate of
+** a block comes out of one mask, so splitting never rescans a byte.
+**/
+
+#include "xScan.h"
+
+#include <cstring>
+
+/*!
+** Instruction sets.
+** ----------------------------------------------------------------------------
+** SSE2 is part of every x64 cpu, AVX2 is checked at run time where the
+** compiler can build it on its own (g++, clang), or taken for granted
+** when the whole build targets it (/arch:AVX2).
+** ----------------------------------------------------------------------------
+**/
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#   define XSCAN_SSE2
+#   include <emmintrin.h>
+#endif
+
+#if defined( __GNUC__ ) && ( defined( __x86_64__ ) || defined( __i386__ ) )
+#   define XSCAN_AVX2
+#   define XSCAN_AVX2_TARGET __attribute__( ( target( "avx2" ) ) )
+#   include <immintrin.h>
+#elif defined( __AVX2__ )
+#   define XSCAN_AVX2
+#   define XSCAN_AVX2_TARGET
+#   include <immintrin.h>
+#endif
+
+#if defined( _MSC_VER )
+#   include <intrin.h>
+#endif
+
+//-----------------------------------------------------------------------------
+
+namespace xTools
+{
+   using std::size_t;
+   using std::vector;
+
+   static const size_t NPOS( static_cast< size_t >( -1 ) );
+
+   /* Index of the lowest bit set, MASK is never zero. */
+   static inline
+   const unsigned
+      lowestBit( const unsigned MASK )
+   {
+#if defined( _MSC_VER )
+      unsigned long index;
+      _BitScanForward( &index, MASK );
+      return static_cast< unsigned >( index );
+#else
+      return static_cast< unsigned >( __builtin_ctz( MASK ) );
+#endif
+   }
+
+   /*
+    * Confirm the candidates of one block, starting at BASE.
+    * Returns true when the scan is over, first hit found while searching.
+    */
+   static inline
+   const bool
+      visitMask(
+         const uint8_t*    DATA,
+         const size_t      BASE,
+               unsigned    mask,
+         const char*       EOL,
+         const size_t      EOL_LEN,
+               size_t&     next,
+               size_t&     found,
+               vector< size_t >* ends
+      )
+   {
+      while( mask )
+      {
+         const size_t POS( BASE + lowestBit( mask ) );
+         mask &= mask - 1;
+         if( POS < next )
+            continue; /* Inside the EOL just matched. */
+         if( EOL_LEN > 2 && memcmp( DATA + POS + 1, EOL + 1, EOL_LEN - 2 ) != 0 )
+            continue;
+         if( ends == NULL )
+         {
+            found = POS;
+            return true;
+         }
+         ends->push_back( POS + EOL_LEN );
+         next = POS + EOL_LEN;
+      }
+      return false;
+   }
+
+   /* memchr on the first byte, then memcmp, for whatever is left. */
+   static
+   const size_t
+      scanScalar(
+         const uint8_t*    DATA,
+         const size_t      SIZE,
+         const char*       EOL,
+         const size_t      EOL_LEN,
+               size_t      pos,
+               vector< size_t >* ends
+      )
+   {
+      while( pos + EOL_LEN <= SIZE )
+      {
+         const void* HIT( memchr( DATA + pos, EOL[ 0 ], SIZE - EOL_LEN + 1 - pos ) );
+         if( HIT == NULL )
+            break;
+         pos = static_cast< const uint8_t* >( HIT ) - DATA;
+         if( memcmp( DATA + pos + 1, EOL + 1, EOL_LEN - 1 ) != 0 )
+         {
+            pos ++;
+            continue;
+         }
+         if( ends == NULL )
+            return pos;
+         ends->push_back( pos + EOL_LEN );
+         pos += EOL_LEN;
+      }
+      return NPOS;
+   }
+
+#if defined( XSCAN_SSE2 )
+
+   static
+   const size_t
+      scanSSE2(
+         const uint8_t*    DATA,
+         const size_t      SIZE,
+         const char*       EOL,
+         const size_t      EOL_LEN,
+         const size_t      FROM,
+               vector< size_t >* ends
+      )
+   {
+      const __m128i FIRST( _mm_set1_epi8( EOL[ 0 ] ) );
+      const __m128i LAST( _mm_set1_epi8( EOL[ EOL_LEN - 1 ] ) );
+      size_t pos( FROM ), next( FROM ), found( NPOS );
+      for( ; pos + 16 + EOL_LEN - 1 <= SIZE; pos += 16 )
+      {
+         const __m128i HEAD( _mm_loadu_si128(
+            reinterpret_cast< const __m128i* >( DATA + pos ) ) );
+         const __m128i TAIL( _mm_loadu_si128(
+            reinterpret_cast< const __m128i* >( DATA + pos + EOL_LEN - 1 ) ) );
+         const unsigned MASK( _mm_movemask_epi8( _mm_and_si128(
+            _mm_cmpeq_epi8( HEAD, FIRST ), _mm_cmpeq_epi8( TAIL, LAST ) ) ) );
+         if( MASK && visitMask( DATA, pos, MASK, EOL, EOL_LEN, next, found, ends ) )
+            return found;
+      }
+      return scanScalar( DATA, SIZE, EOL, EOL_LEN, pos > next ? pos : next, ends );
+   }
+
+#endif
+
+#if defined( XSCAN_AVX2 )
+
+   XSCAN_AVX2_TARGET
+   static
+   const size_t
+      scanAVX2(
+         const uint8_t*    DATA,
+         const size_t      SIZE,
+         const char*       EOL,
+         const size_t      EOL_LEN,
+         const size_t      FROM,
+               vector< size_t >* ends
+      )
+   {
+      const __m256i FIRST( _mm256_set1_epi8( EOL[ 0 ] ) );
+      const __m256i LAST( _mm256_set1_epi8( EOL[ EOL_LEN - 1 ] ) );
+      size_t pos( FROM ), next( FROM ), found( NPOS );
+      for( ; pos + 32 + EOL_LEN - 1 <= SIZE; pos += 32 )
+      {
+         const __m256i HEAD( _mm256_loadu_si256(
+            reinterpret_cast< const __m256i* >( DATA + pos ) ) );
+         const __m256i TAIL( _mm256_loadu_si256(
+            reinterpret_cast< const __m256i* >( DATA + pos + EOL_LEN - 1 ) ) );
+         const unsigned MASK( static_cast< unsigned >( _mm256_movemask_epi8( _mm256_and_si256(
+            _mm256_cmpeq_epi8( HEAD, FIRST ), _mm256_cmpeq_epi8( TAIL, LAST ) ) ) ) );
+         if( MASK && visitMask( DATA, pos, MASK, EOL, EOL_LEN, next, found, ends ) )
+            return found;
+      }
+      return scanScalar( DATA, SIZE, EOL, EOL_LEN, pos > next ? pos : next, ends );
+   }
+
+   static
+   const bool
+      hasAVX2()
+   {
+#if defined( __GNUC__ )
+      static const bool HAS( __builtin_cpu_supports( "avx2" ) );
+      return HAS;
+#else
+      return true;
+#endif
+   }
+
+#endif
+
+   /* Best kernel this cpu runs. */
+   static
+   const size_t
+      scan(
+         const uint8_t*    DATA,
+         const size_t      SIZE,
+         const char*       EOL,
+         const size_t      EOL_LEN,
+         const size_t      FROM,
+               vector< size_t >* ends
+      )
+   {
+      if( EOL_LEN == 0 || FROM + EOL_LEN > SIZE )
+         return NPOS;
+#if defined( XSCAN_AVX2 )
+      if( hasAVX2() )
+         return scanAVX2( DATA, SIZE, EOL, EOL_LEN, FROM, ends );
+#endif
+#if defined( XSCAN_SSE2 )
+      return scanSSE2( DATA, SIZE, EOL, EOL_LEN, FROM, ends );
+#else
+      return scanScalar( DATA, SIZE, EOL, EOL_LEN, FROM, ends );
+#endif
+   }
+
+   const size_t
+      findEol(
+         const uint8_t* DATA,
+         const size_t   SIZE,
+         const char*    EOL,
+         const size_t   EOL_LEN,
+         const size_t   FROM
+      )
+   {
+      return scan( DATA, SIZE, EOL, EOL_LEN, FROM, NULL );
+   }
+
+   const size_t
+      splitLines(
+         const uint8_t*    DATA,
+         const size_t      SIZE,
+         const char*       EOL,
+         const size_t      EOL_LEN,
+         vector< size_t >& ENDS
+      )
+   {
+      const size_t BEFORE( ENDS.size() );
+      scan( DATA, SIZE, EOL, EOL_LEN, 0, &ENDS );
+      return ENDS.size() - BEFORE;
+   }
+}
+
+// EOF.
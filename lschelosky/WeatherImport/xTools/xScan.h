@@ -0,0 +1,61 @@
+/*!
+** \file    xScan.h
+** \date    2026/10/17 08:00
+** \brief   xTools vectorized EOL and delimiter scanner, definition.
+** \author  A.Godinho (Woody)
+**/
+
+#ifndef __XTOOLS_XSCAN_H__
+#define __XTOOLS_XSCAN_H__
+
+//-----------------------------------------------------------------------------
+
+#include <cstddef>
+#include <vector>
+#include "v8stdint.h"
+
+//-----------------------------------------------------------------------------
+
+namespace xTools
+{
+   /*!
+    * Offset of the first EOL starting at or after FROM and ending at or
+    * before SIZE, static_cast< size_t >( -1 ) when there is none. EOL
+    * is one or more bytes, "\x0D" or "\x0D\x0A" say.
+    *
+    * Scans 32 bytes per step with AVX2 or 16 with SSE2, whichever the
+    * cpu has, and falls back to memchr elsewhere.
+    */
+   const std::size_t
+      findEol(
+         const uint8_t*    DATA,
+         const std::size_t SIZE,
+         const char*       EOL,
+         const std::size_t EOL_LEN,
+         const std::size_t FROM = 0
+      );
+
+   /*!
+    * Split DATA into all its complete lines in one pass, appending the
+    * end of each line, its EOL included, to ENDS. Bytes after the last
+    * EOL are left for the caller to keep until the line completes.
+    *
+    * \return The number of lines found.
+    */
+   const std::size_t
+      splitLines(
+         const uint8_t*             DATA,
+         const std::size_t          SIZE,
+         const char*                EOL,
+         const std::size_t          EOL_LEN,
+         std::vector< std::size_t >& ENDS
+      );
+}
+
+//-----------------------------------------------------------------------------
+
+#endif /* __XTOOLS_XSCAN_H__ */
+
+//-----------------------------------------------------------------------------
+
+// EOF.
@@ -24,11 +24,18 @@
 using std::vector;
 #include <string>
 using std::string;
+#include <cstdio>
 #include <cstring>
 #include <sstream>
 #include <exception>
 #include <stdexcept>
 #include "v8stdint.h"
+#include "xStringView.h"
+
+#if defined( __linux__ ) && defined( __cpp_impl_coroutine )
+#   define XTOOLS_COROUTINES
+#   include <coroutine>
+#endif
 
 #include <ostream>
 using std::ostream;
@@ -78,6 +85,26 @@ typedef enum {
   flowcontrol_hardware
 } flowcontrol_t;
 
+/*!
+ * Enumeration defines the possible IO transports for the serial port.
+ *
+ * transport_io_uring keeps a read permanently posted on the port through
+ * io_uring, it is only available on Linux builds with USE_IO_URING
+ * defined.
+ *
+ * transport_streaming lets the kernel hold each read until a batch of
+ * bytes or a gap after the last one arrives (VMIN/VTIME), for devices
+ * that only stream. The gap is the inter-byte timeout rounded up to
+ * tenths of a second, 0.1 s when there is none, so a read can return up
+ * to one gap past its Timeout. Writes still end at their Timeout. Unix
+ * only.
+ */
+typedef enum {
+  transport_default = 0,
+  transport_io_uring,
+  transport_streaming
+} transport_t;
+
 /*!
  * Structure for setting the timeout of the serial port, times are
  * in milliseconds.
@@ -147,6 +174,318 @@ struct Timeout
   }
 };
 
+/*!
+ * Structure for setting the reconnect policy of the serial port, times
+ * are in milliseconds, see Serial::setReconnect.
+ *
+ * The default, a max_delay of 0, never reconnects.
+ */
+struct Reconnect
+{
+  /*!
+   * Convenience function to generate Reconnect structs that retry
+   * forever with capped exponential backoff.
+   */
+  static
+  const Reconnect backoff(
+    const uint32_t initial_delay = 50,
+    const uint32_t max_delay = 5000,
+    const bool by_serial_number = true
+  )
+  {
+    return Reconnect( initial_delay, max_delay, by_serial_number );
+  }
+
+  /*! Delay from the failure to the first reopen. */
+  uint32_t initial_delay;
+
+  /*! The delay doubles after each failed reopen, up to this. */
+  uint32_t max_delay;
+
+  /*! Also look for the adapter's USB serial number under another path,
+   *  Linux builds with USE_SERIAL_ENUM only.
+   */
+  bool by_serial_number;
+
+  explicit Reconnect(
+    const uint32_t initial_delay_    = 0,
+    const uint32_t max_delay_        = 0,
+    const bool     by_serial_number_ = false
+  )
+  : initial_delay(    initial_delay_    ),
+    max_delay(        max_delay_        ),
+    by_serial_number( by_serial_number_ )
+  {
+     /* nothing. */
+  }
+};
+
+/*!
+ * Port statistics, counted since the port was opened.
+ *
+ * The first counters are kept on this side of the driver. The UART
+ * error counters come from the kernel, TIOCGICOUNT on Linux, and stay 0
+ * where the driver keeps none (ptys, many USB adapters). On Windows they
+ * count the ClearCommError checks that saw each error.
+ */
+struct Statistics
+{
+  /*! Bytes taken from the port. */
+  uint64_t bytes_read;
+
+  /*! Bytes handed to the port. */
+  uint64_t bytes_written;
+
+  /*! Lines read up to their EOL. */
+  uint64_t lines;
+
+  /*! Lines cut short by a timeout or the size limit. */
+  uint64_t partial_lines;
+
+  /*! Reads and readlines that timed out short. */
+  uint64_t timeouts;
+
+  /*! UART receive overruns, bytes lost before the driver saw them. */
+  uint64_t overrun;
+
+  /*! Framing errors. */
+  uint64_t frame;
+
+  /*! Parity errors. */
+  uint64_t parity;
+
+  /*! Breaks received. */
+  uint64_t brk;
+
+  /*! Driver buffer overruns. */
+  uint64_t buf_overrun;
+
+  /*! Reopens after the port failed, see Serial::setReconnect. */
+  uint64_t reconnects;
+
+  Statistics()
+  : bytes_read(    0 ),
+    bytes_written( 0 ),
+    lines(         0 ),
+    partial_lines( 0 ),
+    timeouts(      0 ),
+    overrun(       0 ),
+    frame(         0 ),
+    parity(        0 ),
+    brk(           0 ),
+    buf_overrun(   0 ),
+    reconnects(    0 )
+  {
+     /* nothing. */
+  }
+
+  /*! Counts since BASE, an earlier getStatistics, for periodic logs. */
+  const Statistics
+    operator - ( const Statistics& BASE ) const
+  {
+    Statistics delta;
+    delta.bytes_read    = bytes_read    - BASE.bytes_read;
+    delta.bytes_written = bytes_written - BASE.bytes_written;
+    delta.lines         = lines         - BASE.lines;
+    delta.partial_lines = partial_lines - BASE.partial_lines;
+    delta.timeouts      = timeouts      - BASE.timeouts;
+    delta.overrun       = overrun       - BASE.overrun;
+    delta.frame         = frame         - BASE.frame;
+    delta.parity        = parity        - BASE.parity;
+    delta.brk           = brk           - BASE.brk;
+    delta.buf_overrun   = buf_overrun   - BASE.buf_overrun;
+    delta.reconnects    = reconnects    - BASE.reconnects;
+    return delta;
+  }
+
+  /*! True when the kernel counted any receive error. */
+  const bool
+    hasErrors() const
+  {
+    return overrun || frame || parity || buf_overrun;
+  }
+};
+
+#if defined( __linux__ )
+class Reactor;
+#endif
+
+class Journal;
+class PortWatcher;
+
+#if defined( XTOOLS_COROUTINES )
+
+/*!
+ * Single threaded event loop driving coroutines that co_await serial
+ * reads and writes, see Serial::async_readline and Serial::async_write.
+ *
+ * Each device conversation is written as a plain sequential Task, one
+ * thread interleaves all of them without callbacks.
+ */
+class EventLoop
+{
+public:
+
+  /*!
+   * Coroutine run by the loop. A Task does nothing until spawned, then
+   * the loop owns it until it returns.
+   */
+  class Task
+  {
+  public:
+    class promise_type
+    {
+    public:
+      promise_type() : loop( NULL ) {}
+
+      Task
+        get_return_object()
+      {
+        return Task( std::coroutine_handle< promise_type >::from_promise( *this ) );
+      }
+
+      std::suspend_always
+        initial_suspend() noexcept { return std::suspend_always(); }
+
+      std::suspend_always
+        final_suspend() noexcept { return std::suspend_always(); }
+
+      void
+        return_void() {}
+
+      void
+        unhandled_exception() { error = std::current_exception(); }
+
+      EventLoop          *loop;   /* Loop the task was spawned on. */
+      std::exception_ptr error;   /* Rethrown by the loop once done. */
+    };
+
+    Task( Task &&other ) noexcept : _handle( other._handle )
+    {
+      other._handle = nullptr;
+    }
+
+    ~Task()
+    {
+      if( _handle )
+        _handle.destroy();
+    }
+
+  private:
+    friend class EventLoop;
+
+    explicit Task( std::coroutine_handle< promise_type > handle )
+    : _handle( handle ) {}
+
+    /* Disable copy constructors. */
+    Task( const Task& );
+    Task& operator = ( const Task& );
+
+    std::coroutine_handle< promise_type > _handle;
+  };
+
+  /*!
+   * Base of everything a Task co_awaits on the loop: a port turning
+   * readable or writable, a timeout, or both.
+   */
+  class Waiter
+  {
+  public:
+    virtual ~Waiter() {}
+
+    /* Park the awaiting task on its loop. */
+    void
+      await_suspend( std::coroutine_handle< Task::promise_type > task );
+
+  protected:
+    /* Wait on fd, or only for timeout milliseconds when fd is -1. */
+    Waiter( const int fd, const bool write, const uint32_t timeout );
+
+    /* fd turned ready, return true when the wait is over. */
+    virtual const bool
+      ready() { return true; }
+
+    /* timeout passed before the wait was over. */
+    virtual void
+      expire() {}
+
+    std::exception_ptr _error;   /* Rethrown by await_resume. */
+
+  private:
+    friend class EventLoop;
+
+    int       _fd;
+    bool      _write;
+    uint32_t  _timeout;
+    int64_t   _deadline;
+
+    std::coroutine_handle< Task::promise_type > _task;
+  };
+
+  /*! Awaitable pause, the coroutine replacement for xSleep. */
+  class Sleep : public Waiter
+  {
+  public:
+    explicit Sleep( const uint32_t timeout ) : Waiter( -1, false, timeout ) {}
+
+    const bool
+      await_ready() const { return false; }
+
+    void
+      await_resume() const {}
+  };
+
+  /*!
+   * \throw serial::IOException
+   */
+  EventLoop();
+
+  /*! Destructor, tasks still running are destroyed where they wait. */
+  virtual ~EventLoop();
+
+  /*! Hand task to the loop, it starts on the next poll. */
+  void
+    spawn( Task task );
+
+  /*! Number of tasks not finished yet. */
+  const size_t
+    size() const;
+
+  /*!
+   * Run every task that can make progress, waiting up to timeout
+   * milliseconds for a port or a timeout when none can.
+   *
+   * \return The number of times a task was resumed.
+   *
+   * \throw serial::IOException
+   * \throw Whatever a task let escape, the task is finished by then.
+   */
+  const size_t
+    poll( const uint32_t timeout );
+
+  /*! Poll until every task is finished or stop is called from one. */
+  void
+    run();
+
+  /*! Make run return. */
+  void
+    stop();
+
+  /*! co_await EventLoop::sleep( ms ) pauses the calling task only. */
+  static Sleep
+    sleep( const uint32_t timeout );
+
+private:
+  /* Disable copy constructors. */
+  EventLoop( const EventLoop& );
+  EventLoop& operator = ( const EventLoop& );
+
+  class EventLoopImpl;
+  EventLoopImpl *_pimpl;
+};
+
+#endif
+
 /*!
  * Class that provides a portable serial port interface.
  */
@@ -346,6 +685,24 @@ public:
   const string
     readline( const size_t size = 65536, const string &eol = "\n" );
 
+  /*! Reads in a line or until a given delimiter has been processed,
+   *  without copying it.
+   *
+   * Same as readline, but the line is not copied out of the receive
+   * buffer. The view stays valid until the next call that reads from,
+   * flushes or closes this port.
+   *
+   * \param size A maximum length of a line, defaults to 65536 (2^16)
+   * \param eol A string to match against for the EOL.
+   *
+   * \return A stringView over the line, eol included.
+   *
+   * \throw serial::PortNotOpenedException
+   * \throw serial::SerialException
+   */
+  const stringView
+    readline_view( const size_t size = 65536, const string &eol = "\n" );
+
   /*! Reads in multiple lines until the serial port times out.
    *
    * This requires a timeout > 0 before it can be run. It will read until a
@@ -603,6 +960,170 @@ public:
   const flowcontrol_t
     getFlowcontrol() const;
 
+  /*! Sets the IO transport for the serial port.
+   *
+   * The transport is chosen when the port is opened, an open port is
+   * closed and opened again with the new transport.
+   *
+   * \param transport IO transport used, default is transport_default,
+   * possible values are: transport_default, transport_io_uring,
+   * transport_streaming
+   *
+   * \throw std::invalid_argument
+   */
+  void
+    setTransport( const transport_t transport );
+
+  /*! Gets the IO transport for the serial port.
+   *
+   * \see Serial::setTransport
+   */
+  const transport_t
+    getTransport() const;
+
+  /*! Sets the low-latency profile for the serial port.
+   *
+   * On Linux the driver is asked for ASYNC_LOW_LATENCY through
+   * TIOCSSERIAL, it hands received bytes over right away instead of
+   * batching them. Drivers without serial_struct support, ptys say,
+   * are left as they are. Elsewhere the setting is only stored.
+   *
+   * Rates outside the termios table, set with setBaudrate, need no
+   * profile: Linux takes them through termios2 and BOTHER.
+   *
+   * \param low_latency Defaults to false, the driver default.
+   *
+   * \throw serial::IOException
+   */
+  void
+    setLowLatency( const bool low_latency = true );
+
+  /*! Gets the low-latency profile for the serial port.
+   *
+   * \see Serial::setLowLatency
+   */
+  const bool
+    getLowLatency() const;
+
+  /*! Sets the latency timer of the USB-serial adapter, in milliseconds.
+   *
+   * FTDI adapters hold received bytes for up to latency_timer ms, 16 by
+   * default, before they hand a short packet to the host. On Linux the
+   * adapter's sysfs latency_timer is lowered to this value at open, or
+   * right away when already open, and put back as it was on close.
+   *
+   * Ports without a latency_timer, and writes sysfs refuses (it needs
+   * root or a udev rule), leave the adapter as it is: check with
+   * getAdapterLatency. Elsewhere the setting is only stored.
+   *
+   * \param millis 1 to 255, 0 leaves the adapter alone, the default.
+   *
+   * \throw std::invalid_argument above 255 ms.
+   */
+  void
+    setLatencyTimer( const uint32_t millis = 1 );
+
+  /*! Gets the latency timer asked for.
+   *
+   * \see Serial::setLatencyTimer
+   */
+  const uint32_t
+    getLatencyTimer() const;
+
+  /*! Gets the latency timer the adapter runs with now, in milliseconds,
+   * 0 when the port has none or is closed.
+   *
+   * \see Serial::setLatencyTimer
+   */
+  const uint32_t
+    getAdapterLatency() const;
+
+  /*! Sets the reconnect policy for the serial port.
+   *
+   * Once a read or write fails, an adapter reset or unplug say, the port
+   * is closed and reads and writes come back short, as on a timeout,
+   * instead of throwing. Each of them first tries to reopen the port if
+   * the backoff delay is over, waiting for it up to its own timeout.
+   * The delay starts at initial_delay and doubles up to max_delay.
+   *
+   * The port reopens at the same path, or with by_serial_number at any
+   * path now carrying the same USB serial number: a PortWatcher notices
+   * the adapter as it is plugged back in, no rescan of the ports, and
+   * the reopen then waits for it instead of sleeping. Lines held before the
+   * failure are still read first, a line cut by it is read as partial.
+   *
+   * Reads through a Reactor or async_readline are not covered.
+   *
+   * \param reconnect A serial::Reconnect, the default never reconnects.
+   *
+   * \see serial::Reconnect
+   */
+  void
+    setReconnect( const Reconnect &reconnect );
+
+  /*! Gets the reconnect policy for the serial port.
+   *
+   * \see Serial::setReconnect
+   */
+  const Reconnect
+    getReconnect() const;
+
+  /*! True while the port is closed waiting to reconnect.
+   *
+   * \see Serial::setReconnect
+   */
+  const bool
+    isReconnecting() const;
+
+  /*! Captures the port traffic into a journal file.
+   *
+   * Every chunk received and sent from now on is appended to path with
+   * a monotonic timestamp and its direction, see serial::Journal. A
+   * Replay plays it back at getPort(), in real time or faster.
+   *
+   * \param path Journal file, truncated, empty stops the capture.
+   *
+   * \throw serial::IOException
+   */
+  void
+    setCapture( const string &path );
+
+  /*! Why the capture stopped on its own, 0 while it records.
+   *
+   * Each record is flushed as it is written. The first write that
+   * fails, a full disk say, closes the journal after the last whole
+   * record and leaves its errno here.
+   *
+   * \see Serial::setCapture, Journal::getError
+   */
+  const int
+    getCaptureError() const;
+
+  /*! Finds the baudrate the device talks at and sets it.
+   *
+   * Each candidate rate is set in turn, probe written if any, and what
+   * arrives within dwell milliseconds is scored by how well it frames:
+   * printable ASCII and line ends count for it, anything else against.
+   * A $ sentence with a good *hh checksum, or a *XXX: command reply as
+   * *PX0:, proves the rate and ends the search at once.
+   *
+   * Passive NMEA talkers send about once a second, give them a dwell
+   * of 1100 ms or more; devices that answer a probe need much less.
+   *
+   * \param candidates Rates to try, most likely first.
+   * \param dwell Milliseconds to listen at each rate.
+   * \param probe Written after each rate change, empty to only listen.
+   *
+   * \return The rate set, 0 when nothing framed, the rate is then left
+   * as it was.
+   *
+   * \throw serial::PortNotOpenedException
+   * \throw serial::IOException
+   */
+  const uint32_t
+    detectBaudrate( const vector< uint32_t > &candidates,
+                    const uint32_t dwell = 250, const string &probe = "" );
+
   /*! Flush the input and output buffers */
   void
     flush();
@@ -676,6 +1197,107 @@ public:
   const bool
     getCD() const;
 
+  /*! Returns the port statistics since it was opened.
+   *
+   * Waits for a read or write in progress, the counters are theirs.
+   *
+   * \see serial::Statistics
+   */
+  const Statistics
+    getStatistics() const;
+
+#if defined( XTOOLS_COROUTINES )
+
+  /*! Awaitable line, see async_readline. */
+  class ReadlineAwaiter : public EventLoop::Waiter
+  {
+  public:
+    const bool
+      await_ready();
+
+    const string
+      await_resume();
+
+  private:
+    friend class Serial;
+
+    ReadlineAwaiter( Serial &serial, const string &eol,
+                     const uint32_t timeout, const size_t size );
+
+    virtual const bool
+      ready();
+
+    virtual void
+      expire();
+
+    Serial  &_serial;
+    string  _eol;
+    size_t  _size;
+    string  _line;
+  };
+
+  /*! Awaitable write, see async_write. */
+  class WriteAwaiter : public EventLoop::Waiter
+  {
+  public:
+    const bool
+      await_ready();
+
+    const size_t
+      await_resume();
+
+  private:
+    friend class Serial;
+
+    WriteAwaiter( Serial &serial, const string &data, const uint32_t timeout );
+
+    virtual const bool
+      ready();
+
+    Serial  &_serial;
+    string  _data;
+    size_t  _written;
+  };
+
+  /*! Reads a line from within an EventLoop::Task.
+   *
+   * co_await port.async_readline( eol, timeout ) suspends the task until
+   * a line is complete and lets the loop run the other tasks meanwhile.
+   * Like readline, a timeout yields whatever was read so far.
+   *
+   * \param eol A string to match against for the EOL.
+   * \param timeout Milliseconds to wait for the line, Timeout::max()
+   * waits forever.
+   * \param size A maximum length of a line, defaults to 65536 (2^16)
+   *
+   * \return An awaitable resuming with a std::string.
+   *
+   * \throw serial::PortNotOpenedException
+   * \throw std::invalid_argument with any other than transport_default.
+   */
+  ReadlineAwaiter
+    async_readline(
+      const string    &eol      = "\n",
+      const uint32_t  timeout   = Timeout::max(),
+      const size_t    size      = 65536
+    );
+
+  /*! Writes data from within an EventLoop::Task.
+   *
+   * co_await port.async_write( data, timeout ) suspends the task while
+   * the port can't take more bytes.
+   *
+   * \return An awaitable resuming with the number of bytes written,
+   * less than data.size() when timeout passed first.
+   *
+   * \throw serial::PortNotOpenedException
+   * \throw std::invalid_argument with any other than transport_default.
+   */
+  WriteAwaiter
+    async_write( const string &data, const uint32_t timeout = Timeout::max() );
+
+#endif
+
 private:
   /* Disable copy constructors. */
   Serial( const Serial& );
@@ -689,11 +1311,85 @@ private:
   class ScopedReadLock;
   class ScopedWriteLock;
 
-  /* Read common function. */
+  /* Receive buffer, shared by read, readline and readlines. */
+  class ReadBuffer;
+  ReadBuffer *_rxbuf;
+
+  /* Userspace counters, under the read and write locks. */
+  Statistics _stats;
+
+  /* Reconnect policy and state, under the read and write locks. */
+  Reconnect _reconnect;
+  volatile bool _lost;     /* Closed after a failure, not yet reopened. */
+  uint32_t  _delay;        /* Backoff before the next reopen. */
+  uint32_t  _retry_tick;   /* Tick of the next reopen. */
+  string    _hardware_id;  /* USB id with the serial number, if known. */
+  PortWatcher *_watcher;   /* Ports table while _hardware_id is known. */
+
+  /* Close the port after a failure, false if the policy never
+   * reconnects: the caller throws then. */
+  const bool
+    _lose();
+
+  /* Reopen a lost port once the backoff is over, waiting for it up to
+   * timeout ms, or one backoff step when timeout is 0. True when the
+   * port is open again. */
+  const bool
+    _reopen( const uint32_t timeout );
+
+  /* _reopen by _hardware_id: wait on _watcher up to wait ms for the
+   * adapter to show up, at any path, and open it there. */
+  const bool
+    _reattach( const uint32_t wait );
+
+  /* Remember the USB id of the port just opened, for by_serial_number,
+   * and keep a PortWatcher for it. */
+  void
+    _identify();
+
+  /* Capture journal, NULL when not capturing. */
+  Journal *_capture;
+
+  /* Count a line of LEN bytes at DATA, complete when it ends in EOL. */
+  void
+    _countLine( const uint8_t *data, const size_t len, const string &eol );
+
+  /* Read common function, serves the receive buffer first. */
   const size_t
     _read( uint8_t *buffer, const size_t size );
 
-  /* Write common function. */
+  /* Pull the next chunk from the port into the receive buffer. */
+  const size_t
+    _fill( const size_t size );
+
+  /* Length of the next line held in the receive buffer, reading more
+   * from the port as needed. */
+  const size_t
+    _scanline( const size_t size, const string &eol, bool &timeout );
+
+#if defined( __linux__ )
+  friend class Reactor;
+
+  /* Move what the driver holds into the receive buffer, never waits. */
+  const size_t
+    _drain();
+
+  /* Pop the next complete line from the receive buffer, no port IO.
+   * With partial, whatever is buffered counts as a line. */
+  const bool
+    _popline( string &line, const size_t size, const string &eol,
+              const bool partial = false );
+
+  /* Write what the driver takes right away, never waits. */
+  const size_t
+    _trywrite( const uint8_t *data, const size_t length );
+
+  /* File descriptor of the open port. */
+  const int
+    _fd() const;
+#endif
+
+  /* Write common function, takes the locks. */
   const size_t
     _write( const uint8_t *data, const size_t length );
 };
@@ -813,6 +1509,314 @@ public:
   }
 };
 
+#if defined( __linux__ )
+
+/*!
+ * Serves many open serial ports from a single thread.
+ *
+ * Every registered port is watched through one epoll set. When a port
+ * turns readable, the bytes the driver holds are moved into the port's
+ * receive buffer and every completed line (or eol terminated frame) is
+ * delivered to the port's handler. Reading a registered port directly
+ * while the reactor runs is not supported.
+ */
+class Reactor
+{
+public:
+
+  /*!
+   * Receives the lines of the ports it is registered with.
+   */
+  class Handler
+  {
+  public:
+    virtual ~Handler() {}
+
+    /*! A complete line, eol included, was read from port. */
+    virtual void
+      onLine( Serial &port, const string &line ) = 0;
+
+    /*! Reading port failed, it was already removed from the reactor. */
+    virtual void
+      onError( Serial & /*port*/, const std::exception & /*e*/ ) {}
+  };
+
+  /*!
+   * \throw serial::IOException
+   */
+  Reactor();
+
+  /*! Destructor, registered ports are left open. */
+  virtual ~Reactor();
+
+  /*!
+   * Watch an open port and deliver its lines to handler.
+   *
+   * \param port An open serial port, it must outlive its registration.
+   * \param handler Receives the lines read from port.
+   * \param eol A string to match against for the EOL.
+   * \param size A maximum length of a line, longer lines are delivered
+   * in pieces of size bytes, as readline does.
+   *
+   * \throw serial::PortNotOpenedException
+   * \throw serial::IOException
+   */
+  void
+    add(
+      Serial        &port,
+      Handler       &handler,
+      const string  &eol  = "\n",
+      const size_t  size  = 65536
+    );
+
+  /*! Stop watching port. */
+  void
+    remove( Serial &port );
+
+  /*! Number of ports registered. */
+  const size_t
+    size() const;
+
+  /*!
+   * Wait up to timeout milliseconds for any port to turn readable and
+   * dispatch its lines.
+   *
+   * \return The number of lines delivered.
+   *
+   * \throw serial::IOException
+   */
+  const size_t
+    poll( const uint32_t timeout );
+
+  /*! Poll until stop is called, from a handler or from another thread. */
+  void
+    run();
+
+  /*! Make run return. */
+  void
+    stop();
+
+private:
+  /* Disable copy constructors. */
+  Reactor( const Reactor& );
+  Reactor& operator = ( const Reactor& );
+
+  class ReactorImpl;
+  ReactorImpl *_pimpl;
+};
+
+#endif
+
+/*!
+ * Binary journal of the chunks a port received and sent, written by
+ * Serial::setCapture and played back by Replay.
+ *
+ * The file starts with "XSJ1" and the baudrate, 4 bytes little endian.
+ * Each record is the direction byte, the microseconds since the record
+ * before and the length, both LEB128 varints, then the bytes: a line
+ * read in one chunk costs 4 bytes over its own length.
+ */
+class Journal
+{
+public:
+
+  typedef enum {
+    received = 0,
+    sent
+  } direction_t;
+
+  /*! One chunk, as next reads it back. */
+  struct Record
+  {
+    direction_t direction;
+    uint64_t    delay;      /* Microseconds since the record before. */
+    string      data;
+  };
+
+  Journal();
+
+  /*! Destructor, closes the file. */
+  virtual ~Journal();
+
+  /*!
+   * Create path, truncated, to record into.
+   *
+   * \throw serial::IOException
+   */
+  void
+    create( const string &path, const uint32_t baudrate );
+
+  /*!
+   * Open path to read its records back.
+   *
+   * \throw serial::IOException if missing or not a journal.
+   */
+  void
+    open( const string &path );
+
+  /*! Flush and close the file. */
+  void
+    close();
+
+  /*! Baudrate of the port recorded. */
+  const uint32_t
+    getBaudrate() const;
+
+  /*! Append a chunk, timestamped now, and flush it. Safe from the read
+   *  and the write side at once. A failed write closes the file, see
+   *  getError. */
+  void
+    record( const direction_t direction, const uint8_t *data,
+            const size_t size );
+
+  /*! errno of the record that failed, 0 if none. */
+  const int
+    getError() const;
+
+  /*! Read the next record, false at the end of the journal. */
+  const bool
+    next( Record &record );
+
+private:
+  /* Disable copy constructors. */
+  Journal( const Journal& );
+  Journal& operator = ( const Journal& );
+
+  class Mutex;
+  Mutex    *_mutex;
+  FILE     *_file;
+  uint32_t  _baudrate;
+  uint64_t  _last;       /* Timestamp of the last record, microseconds. */
+  int       _error;      /* errno of the record that failed, 0 if none. */
+};
+
+#if !defined( _WIN32 )
+
+/*!
+ * Pair of connected virtual serial ports, built on openpty.
+ *
+ * The port end is a path that a Serial, or either importer, opens like
+ * any other <port>. The driver end is read and written through this
+ * object by a test driver, standing in for the device at the other end
+ * of the cable.
+ */
+class VirtualPortPair
+{
+public:
+
+  /*!
+   * \throw serial::IOException
+   */
+  VirtualPortPair();
+
+  /*! Destructor, closes both ends. */
+  virtual ~VirtualPortPair();
+
+  /*! Path of the port end, something like '/dev/pts/3'. */
+  const string
+    getPort() const;
+
+  /*! File descriptor of the driver end. */
+  const int
+    getDriverFd() const;
+
+  /*! Write to the driver end, the bytes show up on the port end. Blocks
+   *  while the port end is not reading and its buffer is full.
+   *
+   * \return A size_t representing the number of bytes written.
+   *
+   * \throw serial::IOException
+   */
+  const size_t
+    write( const uint8_t *data, const size_t size );
+
+  /*! Write a string to the driver end. */
+  const size_t
+    write( const string &data );
+
+  /*! Read what the port end wrote, waiting up to timeout milliseconds
+   *  for the first byte, then taking whatever else is already there.
+   *
+   * \return A size_t representing the number of bytes read, zero on
+   *         timeout.
+   *
+   * \throw serial::IOException
+   */
+  const size_t
+    read( uint8_t *buffer, const size_t size, const uint32_t timeout = 0 );
+
+  /*! Read up to size bytes the port end wrote into a string. */
+  const string
+    read( const size_t size = 65536, const uint32_t timeout = 0 );
+
+private:
+  /* Disable copy constructors. */
+  VirtualPortPair( const VirtualPortPair& );
+  VirtualPortPair& operator = ( const VirtualPortPair& );
+
+  int     _driver;   /* Pseudo-terminal master. */
+  int     _port;     /* Slave, kept open so the line never hangs up. */
+  string  _name;     /* Slave path. */
+};
+
+/*!
+ * Plays a Journal back on a VirtualPortPair: what the port once
+ * received arrives at getPort() with its recorded timing, scaled by
+ * speed, so a Serial or either importer reads the capture as the live
+ * device. What they write is drained and dropped.
+ */
+class Replay
+{
+public:
+
+  /*!
+   * \param path Journal written by Serial::setCapture.
+   * \param speed 1 plays in real time, 10 ten times faster, 0 as fast
+   * as the port is read.
+   *
+   * \throw serial::IOException
+   */
+  Replay( const string &path, const double speed = 1.0 );
+
+  /*! Destructor, stops the playback and closes both ends. */
+  virtual ~Replay();
+
+  /*! Path of the port end to open, see VirtualPortPair. */
+  const string
+    getPort() const;
+
+  /*! Baudrate the journal was recorded at. */
+  const uint32_t
+    getBaudrate() const;
+
+  /*!
+   * Start playing, after delay milliseconds: time for the reader to
+   * open and purge getPort(), as the importers do.
+   *
+   * \throw serial::IOException
+   */
+  void
+    start( const uint32_t delay = 0 );
+
+  /*! True once the whole journal was played. */
+  const bool
+    done() const;
+
+  /*! Block until the whole journal was played. */
+  void
+    wait();
+
+private:
+  /* Disable copy constructors. */
+  Replay( const Replay& );
+  Replay& operator = ( const Replay& );
+
+  class ReplayImpl;
+  ReplayImpl *_pimpl;
+};
+
+#endif
+
 /*!
  * Structure that describes a serial device.
  */
@@ -839,6 +1843,82 @@ struct PortInfo {
 vector< PortInfo >
 list_ports();
 
+#if defined( __linux__ ) && defined( USE_SERIAL_ENUM )
+
+/*!
+ * Table of the serial ports, built once by list_ports and kept current
+ * from inotify events on /dev, where device nodes come and go with the
+ * adapters. Only the port that changed is looked up in sysfs.
+ *
+ * A re-plugged adapter shows up within milliseconds, its node may still
+ * belong to root until udev applies its rules, retry a failing open.
+ */
+class PortWatcher
+{
+public:
+
+  /*!
+   * Receives the ports that come and go.
+   */
+  class Handler
+  {
+  public:
+    virtual ~Handler() {}
+
+    /*! port appeared, already in the table. */
+    virtual void
+      onAdd( const PortInfo & /*port*/ ) {}
+
+    /*! port disappeared, already out of the table. */
+    virtual void
+      onRemove( const PortInfo & /*port*/ ) {}
+  };
+
+  /*!
+   * Build the table and start watching.
+   *
+   * \throw serial::IOException
+   */
+  PortWatcher();
+
+  /*! Destructor. */
+  virtual ~PortWatcher();
+
+  /*! The ports known now, no IO. */
+  const vector< PortInfo >
+    ports() const;
+
+  /*!
+   * Wait up to timeout milliseconds for ports to come or go, update the
+   * table and tell handler.
+   *
+   * \return The number of ports added or removed.
+   *
+   * \throw serial::IOException
+   */
+  const size_t
+    poll( Handler &handler, const uint32_t timeout );
+
+  /*! Readable when poll has news, for a caller's own select or epoll. */
+  const int
+    getFd() const;
+
+private:
+  /* Disable copy constructors. */
+  PortWatcher( const PortWatcher& );
+  PortWatcher& operator = ( const PortWatcher& );
+
+  /* One wait of up to wait_ms for the pending events, -1 waits forever. */
+  const size_t
+    read_events( Handler &handler, const vector< string > &patterns,
+                 const int wait_ms );
+
+  int                 _fd;      /* inotify instance watching /dev. */
+  vector< PortInfo >  _ports;   /* The table. */
+};
+
+#endif
+
 }
 
 #if defined( USE_SERIAL_LIST )
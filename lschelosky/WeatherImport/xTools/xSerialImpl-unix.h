@@ -16,7 +16,7 @@
 #ifndef SERIAL_IMPL_UNIX_H
 #define SERIAL_IMPL_UNIX_H
 
-#include "serial/serial.h"
+#include "xSerial.h"
 
 #include <pthread.h>
 
@@ -29,16 +29,56 @@ using std::invalid_argument;
 using serial::SerialException;
 using serial::IOException;
 
-class MillisecondTimer {
+// io_uring transport, see transport_io_uring
+class IoUring;
+
+// Absolute CLOCK_MONOTONIC deadline, in integer nanoseconds.
+class Deadline {
 public:
-  MillisecondTimer(const uint32_t millis);         
-  int64_t remaining();
+  // Deadline timeout_ns from now.
+  explicit Deadline (int64_t timeout_ns);
+
+  static Deadline
+  fromMillis (int64_t millis);
+
+  // Deadline at an absolute CLOCK_MONOTONIC time, see now ().
+  static Deadline
+  at (int64_t expiry_ns);
+
+  // CLOCK_MONOTONIC now, in nanoseconds.
+  static int64_t
+  now ();
+
+  int64_t
+  expiry () const { return expiry_; }
+
+  // Nanoseconds left, zero or less once expired.
+  int64_t
+  remaining () const;
+
+  // Milliseconds left, rounded down.
+  int64_t
+  remainingMillis () const;
+
+  // What is left as a timespec for pselect, never negative.
+  timespec
+  remainingTimespec () const;
+
+#if defined(__linux__)
+  // Arm a CLOCK_MONOTONIC timerfd to fire at this deadline, so several
+  // deadlines can share one epoll set.
+  void
+  arm (int timerfd) const;
+#endif
 
 private:
-  static timespec timespec_now();
-  timespec expiry;
+  int64_t expiry_;
 };
 
+// A timespec of ns nanoseconds, ns >= 0.
+timespec
+timespec_from_ns (int64_t ns);
+
 class serial::Serial::SerialImpl {
 public:
   SerialImpl (const string &port,
@@ -68,12 +108,25 @@ public:
   void
   waitByteTimes (size_t count);
 
+  // waitReadable with a nanosecond timeout
+  bool
+  waitReadableNs (int64_t timeout_ns);
+
   size_t
   read (uint8_t *buf, size_t size = 1);
 
+  // Wait for the first byte within the read timeout, then a single read
+  // the kernel holds for a batch, see transport_streaming
+  size_t
+  readBatch (uint8_t *buf, size_t size);
+
   size_t
   write (const uint8_t *data, size_t length);
 
+  // Single non-blocking write, returns 0 when the driver is full
+  size_t
+  writeSome (const uint8_t *data, size_t length);
+
   void
   flush ();
 
@@ -83,6 +136,12 @@ public:
   void
   flushOutput ();
 
+  void
+  synchronize (ostream &out);
+
+  void
+  purge ();
+
   void
   sendBreak (int duration);
 
@@ -110,6 +169,10 @@ public:
   bool
   getCD ();
 
+  // Add the kernel UART error counts since open to stats
+  void
+  getErrorCounters (Statistics &stats);
+
   void
   setPort (const string &port);
 
@@ -117,7 +180,7 @@ public:
   getPort () const;
 
   void
-  setTimeout (Timeout &timeout);
+  setTimeout (const Timeout &timeout);
 
   Timeout
   getTimeout () const;
@@ -152,6 +215,27 @@ public:
   flowcontrol_t
   getFlowcontrol () const;
 
+  void
+  setTransport (transport_t transport);
+
+  transport_t
+  getTransport () const;
+
+  void
+  setLowLatency (bool low_latency);
+
+  bool
+  getLowLatency () const;
+
+  void
+  setLatencyTimer (uint32_t millis);
+
+  uint32_t
+  getLatencyTimer () const;
+
+  uint32_t
+  getAdapterLatency () const;
+
   void
   readLock ();
 
@@ -164,9 +248,19 @@ public:
   void
   writeUnlock ();
 
+  int
+  getFd () const;
+
 protected:
   void reconfigurePort ();
 
+  // Set or clear ASYNC_LOW_LATENCY, where the driver has serial_struct
+  void applyLowLatency (bool low_latency);
+
+  // Write latency_timer_ to the adapter's sysfs latency_timer, or put
+  // back the value found at open when latency_timer_ is 0
+  void applyLatencyTimer ();
+
 private:
   string port_;               // Path to the file descriptor
   int fd_;                    // The current file descriptor
@@ -183,6 +277,14 @@ private:
   bytesize_t bytesize_;       // Size of the bytes
   stopbits_t stopbits_;       // Stop Bits
   flowcontrol_t flowcontrol_; // Flow Control
+  transport_t transport_;     // IO transport, chosen at open
+  IoUring *uring_;            // Ring of the io_uring transport, if open
+  bool low_latency_;          // Ask the driver for ASYNC_LOW_LATENCY
+  bool low_latency_applied_;  // ASYNC_LOW_LATENCY set by us, clear on close
+  uint32_t latency_timer_;    // Adapter latency timer asked for, 0 for none
+  string latency_path_;       // sysfs latency_timer of the open port, if any
+  int latency_saved_;         // latency_timer found at open, -1 if untouched
+  Statistics icount_base_;    // Kernel UART error counts at open
 
   // Mutex used to lock the read functions
   pthread_mutex_t read_mutex;
@@ -0,0 +1,157 @@
+/*!
+** \file    xStringView.h
+** \date    2026/10/17 08:00
+** \brief   xTools non owning string view, definition.
+** \author  A.Godinho (Woody)
+**/
+
+#ifndef __XTOOLS_XSTRINGVIEW_H__
+#define __XTOOLS_XSTRINGVIEW_H__
+
+//-----------------------------------------------------------------------------
+
+#include <cstring>
+#include <string>
+#include <stdexcept>
+#include <ostream>
+
+/*!
+** C++ 17 std::string_view, when available.
+** ----------------------------------------------------------------------------
+**/
+#if __cplusplus >= 201703L || ( defined( _MSVC_LANG ) && _MSVC_LANG >= 201703L )
+#   define XTOOLS_STD_STRING_VIEW
+#   include <string_view>
+#endif
+
+//-----------------------------------------------------------------------------
+
+namespace xTools
+{
+#if defined( XTOOLS_STD_STRING_VIEW )
+
+   typedef std::string_view
+      stringView;
+
+#else
+
+   /*!
+    * Read only view over characters owned by someone else, the subset
+    * of std::string_view used by xTools. The viewed characters MUST
+    * outlive the view.
+    */
+   class stringView
+   {
+   public:
+      typedef const char*  const_iterator;
+      typedef std::size_t  size_type;
+
+      static const size_type npos = static_cast< size_type >( -1 );
+
+      stringView():
+         _data( NULL ),
+         _size( 0 )
+      {
+         /* Nothing. */
+      }
+
+      stringView( const char* DATA, const size_type SIZE ):
+         _data( DATA ),
+         _size( SIZE )
+      {
+         /* Nothing. */
+      }
+
+      stringView( const char* STR ):
+         _data( STR ),
+         _size( strlen( STR ) )
+      {
+         /* Nothing. */
+      }
+
+      stringView( const std::string& STR ):
+         _data( STR.data() ),
+         _size( STR.size() )
+      {
+         /* Nothing. */
+      }
+
+      const char*       data()   const { return _data; }
+      const size_type   size()   const { return _size; }
+      const size_type   length() const { return _size; }
+      const bool        empty()  const { return _size == 0; }
+      const_iterator    begin()  const { return _data; }
+      const_iterator    end()    const { return _data + _size; }
+
+      const char
+         operator[]( const size_type POS ) const
+      {
+         return _data[ POS ];
+      }
+
+      const stringView
+         substr( const size_type POS = 0, const size_type COUNT = npos ) const
+      {
+         if( POS > _size )
+            throw std::out_of_range( "stringView::substr" );
+         const size_type REST( _size - POS );
+         return stringView( _data + POS, COUNT < REST ? COUNT : REST );
+      }
+
+      const size_type
+         find( const char CC, const size_type POS = 0 ) const
+      {
+         if( POS >= _size )
+            return npos;
+         const void* HIT( memchr( _data + POS, CC, _size - POS ) );
+         return HIT ? static_cast< const char* >( HIT ) - _data : npos;
+      }
+
+      const int
+         compare( const stringView& OTHER ) const
+      {
+         const size_type N( _size < OTHER._size ? _size : OTHER._size );
+         const int CMP( N ? memcmp( _data, OTHER._data, N ) : 0 );
+         if( CMP )
+            return CMP;
+         return _size < OTHER._size ? -1 : ( _size > OTHER._size ? 1 : 0 );
+      }
+
+   private:
+      const char* _data;
+      size_type   _size;
+   };
+
+   inline
+   const bool
+      operator == ( const stringView& A, const stringView& B )
+   {
+      return A.size() == B.size() && A.compare( B ) == 0;
+   }
+
+   inline
+   const bool
+      operator != ( const stringView& A, const stringView& B )
+   {
+      return !( A == B );
+   }
+
+   inline
+   std::ostream&
+      operator << ( std::ostream& out, const stringView& SV )
+   {
+      return out.write( SV.data(), SV.size() );
+   }
+
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+using xTools::stringView;
+
+#endif /* __XTOOLS_XSTRINGVIEW_H__ */
+
+//-----------------------------------------------------------------------------
+
+// EOF.
@@ -20,11 +20,19 @@ using std::fstream;
 void
    WeeditImport::start(
       const string &PORT, 
-      const ulong  SPEED
+      const ulong  SPEED,
+      const ulong  PERIOD,
+      const bool   LOW_LATENCY,
+      const string &JOURNAL
    )
 {
    LOG_INFO( "Import started." );
-   LOG_INFO( "Opening port " << PORT.c_str() << " @ " << SPEED << " bps." );
+   if( SPEED == 0 )
+      LOG_INFO( "Opening port " << PORT.c_str() << ", detecting the speed." );
+   else
+      LOG_INFO( "Opening port " << PORT.c_str() << " @ " << SPEED << " bps." );
+   _startTick = tickMillis();
+   _firstRecord = false;
 
    /* get the filename. */
    const string DATAM_FILE( getOutputFile() );
@@ -36,13 +44,34 @@ void
 
    /* open the serial port. */
    _serial.setPort( PORT );
-   _serial.setBaudrate( SPEED );
+   _serial.setBaudrate( SPEED ? SPEED : SERIAL_SPEED );
    _serial.setTimeout( _TIMEOUT );
+   _serial.setLowLatency( LOW_LATENCY );
+   /* an adapter reset reopens the port, the loop keeps running. */
+   _serial.setReconnect( Reconnect::backoff( RECONNECT_MILLIS, RECONNECT_MAX_MILLIS ) );
    _serial.open();
    _started = _serial.isOpen();
    if( !_started )
       throw runtime_error( "Can't open the specified port!" );
 
+   /* speed 0, score each candidate rate instead of a TIMEOUT_MILLIS guess. */
+   if( SPEED == 0 )
+   {
+      const uint32_t RATES[] = { AUTOBAUD_RATES };
+      const vector< uint32_t > rates( RATES, RATES + sizeof( RATES ) / sizeof( RATES[0] ) );
+      const uint32_t FOUND( _serial.detectBaudrate( rates, AUTOBAUD_DWELL_MILLIS, REQUEST_PX0 ) );
+      if( FOUND == 0 )
+         throw runtime_error( "Can't detect the port speed!" );
+      LOG_INFO( "Detected " << FOUND << " bps after " << tickMillis() - _startTick << " ms." );
+   }
+
+   /* every chunk in and out, for a Replay of this session. */
+   if( !JOURNAL.empty() )
+   {
+      _serial.setCapture( JOURNAL );
+      LOG_INFO( "Capturing to " << JOURNAL.c_str() << "." );
+   }
+
    /* wait until available. */
    //_serial.synchronize( cout );
 
@@ -52,33 +81,39 @@ void
    e = 100;
    f = 100;
 
+#if defined( USE_READER_THREAD )
+   /* the reader thread drains the port, this one parses and writes. */
+   _serial.setTimeout( Timeout::simpleTimeout( READER_TIMEOUT_MILLIS ) );
+   _drops = 0;
+   _reader.start( _serial, RESPONSE_SIZE, RESPONSE_EOL );
+#endif
+
    /* start the communication. */
-   while( !shutdown )
+   const string REQUEST( REQUEST_POLL );
+
+   /* lower the adapter latency timer, measured on both sides. */
+   const uint32_t LATENCY( _serial.getAdapterLatency() );
+   if( LATENCY != 0 && LATENCY != LATENCY_TIMER_MILLIS && LATENCY_TIMER_MILLIS != 0 )
    {
-      /* *PX0, read variable parameters. */
-      if( _serial.write( REQUEST_PX0 ) )
-      {
-         string px0( _serial.readline( RESPONSE_SIZE, RESPONSE_EOL ) );
-         const stringMap map( PX0_map( px0 ) );
-         x = getValue< int >( map, "X", 100 );
-         e = getValue< int >( map, "E", 100 );
-         f = getValue< int >( map, "F", 100 );
-         LOG_DEBUG( "X=[" << x << "], E=[" << e << "], F=[" << f << "]" );
-         LOG_DEBUG( "double=[" << toString( 123.123456, "%6.2f" ) << "]" );
-      }
+      const ulong BEFORE( roundTrip( REQUEST ) );
+      _serial.setLatencyTimer( LATENCY_TIMER_MILLIS );
+      const ulong AFTER( roundTrip( REQUEST ) );
+      LOG_INFO( "Round trip " << BEFORE << " ms at latency_timer " << LATENCY << " ms, "
+         << AFTER << " ms at " << _serial.getAdapterLatency() << " ms." );
+   }
 
-      /* *BX0, read nozzle activity. */
-      if( _serial.write( REQUEST_BX0 ) )
-      {
-         string tmp( _serial.readline( RESPONSE_SIZE, RESPONSE_EXTRA ) );
-         string bx0( _serial.readline( RESPONSE_SIZE, RESPONSE_EOL ) );
-         BX0_report( bx0 );
-      }
+   _statsTick = tickMillis();
+   _lastStats = _serial.getStatistics();
+   while( !shutdown )
+   {
+      logStatistics();
 
-      string tmp( _serial.readline( RESPONSE_SIZE, RESPONSE_EXTRA ) );
+      /* *PX0 and *BX0 in a single write, one round trip for both. */
+      if( _serial.write( REQUEST ) == REQUEST.length() )
+         collectReplies();
 
       /* sleep, the serial timeout MUST BE GREATER THAN this delay. */
-      xSleep( SLEEP_MILLIS );
+      xSleep( PERIOD );
    }
 
    stop();
@@ -90,6 +125,13 @@ void
 {
    if( _started )
    {
+#if defined( USE_READER_THREAD )
+      _reader.stop();
+      LOG_INFO( "Reader: " << _reader.lines() << " lines, "
+         << _reader.highWater() << " queued at most, "
+         << _reader.drops() << " dropped." );
+#endif
+
       if( _ofs.is_open() )
       {
          _ofs.flush();
@@ -134,6 +176,125 @@ const string
    return filename;
 }
 
+void
+   WeeditImport::logStatistics()
+{
+   if( tickMillis() - _statsTick < STATS_MILLIS )
+      return;
+   _statsTick = tickMillis();
+
+   const Statistics STATS( _serial.getStatistics() );
+   const Statistics DELTA( STATS - _lastStats );
+   _lastStats = STATS;
+   LOG_INFO( "Port: " << DELTA.bytes_read << " bytes, "
+      << DELTA.lines << " lines, " << DELTA.partial_lines << " partial, "
+      << DELTA.timeouts << " timeouts." );
+   if( DELTA.hasErrors() || DELTA.brk )
+      LOG_ERROR( "UART: " << DELTA.overrun << " overruns, "
+         << DELTA.frame << " framing, " << DELTA.parity << " parity, "
+         << DELTA.brk << " breaks, " << DELTA.buf_overrun << " buffer overruns!" );
+   if( DELTA.reconnects )
+      LOG_ERROR( "Port lost and reopened " << DELTA.reconnects << " times!" );
+
+   /* the journal stops at its first failed write, say so once. */
+   const int CAPTURE_ERROR( _serial.getCaptureError() );
+   if( CAPTURE_ERROR && CAPTURE_ERROR != _captureError )
+      LOG_ERROR( "Capture stopped, write error " << CAPTURE_ERROR << "!" );
+   _captureError = CAPTURE_ERROR;
+}
+
+const ulong
+   WeeditImport::roundTrip(
+      const string& REQUEST
+   )
+{
+   const ulong START( tickMillis() );
+   if( _serial.write( REQUEST ) == REQUEST.length() )
+      collectReplies();
+   return tickMillis() - START;
+}
+
+void
+   WeeditImport::collectReplies()
+{
+   bool px0( false );
+   bool bx0( false );
+   while( !px0 || !bx0 )
+   {
+      string response;
+      if( !nextReply( response ) )
+      {
+         LOG_ERROR( "Timeout waiting for the"
+            << ( px0 ? "" : " *PX0" ) << ( bx0 ? "" : " *BX0" ) << " reply!" );
+         return;
+      }
+
+      /* the CR LF trailers leave a LF ahead of the next reply. */
+      removeStr( response, EOL_LF_C );
+
+      if( response.compare( 0, CMD_PX0.length(), CMD_PX0 ) == 0 )
+      {
+         PX0_record( response );
+         px0 = true;
+      }
+      else if( response.compare( 0, CMD_BX0.length(), CMD_BX0 ) == 0 )
+      {
+         BX0_report( response );
+         bx0 = true;
+      }
+      else if( response != RESPONSE_EOL )
+         LOG_DEBUG( "Ignored [" << response << "]" );
+   }
+}
+
+const bool
+   WeeditImport::nextReply(
+      string& response
+   )
+{
+#if defined( USE_READER_THREAD )
+   const ulong START( tickMillis() );
+   stampedLine line;
+   while( !_reader.pop( line ) )
+   {
+      if( !_reader.running() )
+         throw runtime_error( "The reader thread stopped!" );
+      if( tickMillis() - START >= TIMEOUT_MILLIS )
+         return false;
+      xSleep( READER_POLL_MILLIS );
+   }
+   if( _reader.drops() != _drops )
+   {
+      LOG_ERROR( "Reader queue full, " << _reader.drops() - _drops << " lines dropped!" );
+      _drops = _reader.drops();
+   }
+   LOG_DEBUG( "queued " << tickMillis() - line.tick << " ms, depth " << _reader.depth() );
+   response.swap( line.text );
+   return response.find( RESPONSE_EOL ) != string::npos;
+#else
+   response = _serial.readline( RESPONSE_SIZE, RESPONSE_EOL );
+   return response.find( RESPONSE_EOL ) != string::npos;
+#endif
+}
+
+void
+   WeeditImport::PX0_record(
+      string& response
+   )  NOEXCEPTION
+{
+   const stringMap map( PX0_map( response ) );
+   if( !_firstRecord && !map.empty() )
+   {
+      LOG_INFO( "First record after " << tickMillis() - _startTick << " ms." );
+      _firstRecord = true;
+   }
+   x = getValue< int >( map, "X", 100 );
+   e = getValue< int >( map, "E", 100 );
+   f = getValue< int >( map, "F", 100 );
+   LOG_DEBUG( "X=[" << x << "], E=[" << e << "], F=[" << f << "]" );
+   LOG_DEBUG( "double=[" << toString( 123.123456, "%6.2f" ) << "]" );
+}
+
 const stringMap
    WeeditImport::PX0_map(
       string& response
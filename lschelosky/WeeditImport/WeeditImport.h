@@ -19,6 +19,17 @@
 #define SERIAL_SPEED          38400
 #define TIMEOUT_MILLIS        10000          /* 10 seconds. */
 #define SLEEP_MILLIS          500
+#define LATENCY_TIMER_MILLIS  1              /* FTDI latency_timer, 0 leaves it. */
+#define STATS_MILLIS          60000          /* port statistics log. */
+#define AUTOBAUD_RATES        38400, 57600, 115200, 19200, 9600, 4800   /* -b, most likely first. */
+#define AUTOBAUD_DWELL_MILLIS 100            /* answers REQUEST_PX0 at once. */
+#define RECONNECT_MILLIS      50             /* first reopen after a failure, */
+#define RECONNECT_MAX_MILLIS  5000           /* doubling up to this. */
+#define REPLAY_DELAY_MILLIS   500            /* -r, for the port to open. */
+
+#define READER_TIMEOUT_MILLIS 250            /* USE_READER_THREAD only. */
+#define READER_POLL_MILLIS    10
+#define READER_CAPACITY       1024           /* lines! */
 
 #define EOL_CR_C              "\x0D"         /* reference. */
 #define EOL_LF_C              "\x0A"         /* reference. */
@@ -38,6 +49,7 @@
 
 #define REQUEST_PX0           CMD_PX0 + REQUEST_EOL
 #define REQUEST_BX0           CMD_BX0 + REQUEST_EOL
+#define REQUEST_POLL          REQUEST_PX0 + REQUEST_BX0  /* pipelined. */
 
 //-----------------------------------------------------------------------------
 
@@ -45,6 +57,16 @@
 #include "xTools/xSerial.h"
 using serial::Serial;
 using serial::Timeout;
+using serial::Statistics;
+using serial::Reconnect;
+
+#if defined( USE_READER_THREAD )
+#include "xTools/xLineReader.h"
+#endif
+
+#if defined( USE_SERIAL_LIST ) || defined( USE_SERIAL_ENUM )
+#include "xTools/xProbe.h"
+#endif
 
 #include <fstream>
 using std::ofstream;
@@ -60,7 +82,15 @@ public:
     */
    WeeditImport():
       _started(  false ),
+      _startTick( 0 ),
+      _firstRecord( false ),
       _serial(   ),
+      _statsTick( 0 ),
+      _lastStats( ),
+      _captureError( 0 ),
+#if defined( USE_READER_THREAD )
+      _reader(   READER_CAPACITY ),
+#endif
       _ofs(      ),
       _TIMEOUT(  Timeout::simpleTimeout( TIMEOUT_MILLIS ) )
    {
@@ -77,12 +107,16 @@ public:
    }
 
    /*!
-    * Start the import.
+    * Start the import, SPEED 0 detects it, LOW_LATENCY asks the driver
+    * for low latency, JOURNAL captures the port traffic.
     */
    void
       start(
          const string& PORT,
-         const ulong   SPEED
+         const ulong   SPEED,
+         const ulong   PERIOD = SLEEP_MILLIS,
+         const bool    LOW_LATENCY = false,
+         const string& JOURNAL = ""
       );
 
    /*!
@@ -100,6 +134,43 @@ private:
    const string
       getOutputFile();
 
+   /*!
+    * Log the port statistics since the last log, every STATS_MILLIS.
+    */
+   void
+      logStatistics();
+
+   /*!
+    * One poll, from the write to its last reply, in ms.
+    */
+   const ulong
+      roundTrip(
+         const string& REQUEST
+      );
+
+   /*!
+    * Read the replies to one REQUEST_POLL, in whatever order they
+    * arrive, matched by their command id.
+    */
+   void
+      collectReplies();
+
+   /*!
+    * Next reply line, false on timeout.
+    */
+   const bool
+      nextReply(
+         string& response
+      );
+
+   /*!
+    * Record the PX0 variables.
+    */
+   void
+      PX0_record(
+         string& response
+      )  NOEXCEPTION;
+
    /*!
     * Parse the response.
     */
@@ -126,7 +197,16 @@ private:
 
 private:
    bool      _started;
+   ulong     _startTick;       /* tickMillis at start, for the log. */
+   bool      _firstRecord;     /* first record already logged. */
    Serial    _serial;
+   ulong     _statsTick;       /* tickMillis of the last statistics log. */
+   Statistics _lastStats;      /* port statistics at that log. */
+   int       _captureError;    /* journal errno already logged. */
+#if defined( USE_READER_THREAD )
+   LineReader _reader;         /* drains _serial on its own thread. */
+   ulong     _drops;           /* _reader drops already logged. */
+#endif
    ofstream  _ofs;
 
    const
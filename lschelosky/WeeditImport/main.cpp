@@ -11,6 +11,9 @@
 #include "stdafx.h"
 #include "WeeditImport.h"
 WeeditImport* _import;
+#if !defined( _WIN32 )
+serial::Replay* _replay;
+#endif
 #include <csignal>
 
 // -----------------------------------------------------------------------------
@@ -21,7 +24,16 @@ const int usageList()
 #if defined( USE_SERIAL_LIST )
    LOG_INFO( "\tWeeditImport -e" );
 #endif
-   LOG_INFO( "\tWeeditImport <port> <speed>" );
+   LOG_INFO( "\tWeeditImport <port> <speed> [<period ms>] [-b] [-j <journal>] [-l]" );
+#if !defined( _WIN32 )
+   LOG_INFO( "\tWeeditImport -r <journal> [<times faster>] [<period ms>] [-l]" );
+#endif
+#if defined( USE_SERIAL_LIST ) || defined( USE_SERIAL_ENUM )
+   LOG_INFO( "\t\t-a  in place of the port, probe all ports for this device." );
+#endif
+   LOG_INFO( "\t\t-b  detect the speed, see AUTOBAUD_RATES." );
+   LOG_INFO( "\t\t-j  <journal> capture the port traffic, see Serial::setCapture." );
+   LOG_INFO( "\t\t-l  low latency, the driver hands over every byte at once." );
 
    return EXIT_SUCCESS;
 }
@@ -34,16 +46,50 @@ void sigint_handler( const int sig )
       delete _import;
       _import = NULL;
    }
+#if !defined( _WIN32 )
+   delete _replay;
+   _replay = NULL;
+#endif
 
    if( sig != 999 )
       LOG_DEBUG( " Import aborted ( Ctrl + C )." );
    exit( EXIT_SUCCESS );
 }
 
+#if defined( USE_SERIAL_LIST ) || defined( USE_SERIAL_ENUM )
+/* -- Probe every port at once, log what sits where, our port or throw. */
+const string probeDevice()
+{
+   vector< probeSpec > specs;
+   /* answers at once, try it first. */
+   specs.push_back( probeSpec( "WeeditImport",  38400, "*PX0" EOL_CR_C, "*PX0",   EOL_CR_C, 150 ) );
+   /* talks on its own, about once a second. */
+   specs.push_back( probeSpec( "WeatherImport", 4800,  "",              "$WIMDA", EOL_CR_C, 700 ) );
+
+   stringVector ports;
+   const vector< serial::PortInfo > INFO( serial::list_ports() );
+   for( size_t i( 0 ); i < INFO.size(); i ++ )
+      ports.push_back( INFO[i].port );
+
+   const ulong START( tickMillis() );
+   const stringMap FOUND( probePorts( ports, specs ) );
+   LOG_INFO( "Probed " << ports.size() << " ports in " << ( tickMillis() - START ) << " ms." );
+   for( stringMap::const_iterator it( FOUND.begin() ); it != FOUND.end(); ++ it )
+      LOG_INFO( "\t" << it->first << " on " << it->second );
+
+   const stringMap::const_iterator IT( FOUND.find( "WeeditImport" ) );
+   if( IT == FOUND.end() )
+      throw runtime_error( "no WeeditImport device found!" );
+   return IT->second;
+}
+#endif
+
 /* -- Project main. */
 int _tmain( int argc, char* argv[] )
 {
    string arg1( SERIAL_PORT );
+   string replay;
+   int    first( 2 );
 
    if( argc > 1 )
    {
@@ -56,12 +102,56 @@ int _tmain( int argc, char* argv[] )
       if( arg1 == "-e" )
          return serialList( cout );
       #endif
+
+      #if !defined( _WIN32 )
+      /* a capture in place of the port, the rest shifts by one. */
+      if( arg1 == "-r" )
+      {
+         if( argc < 3 )
+            return usageList();
+         replay = argv[2];
+         first = 3;
+      }
+      #endif
+
+      #if defined( USE_SERIAL_LIST ) || defined( USE_SERIAL_ENUM )
+      if( arg1 == "-a" )
+         try
+         {
+            arg1 = probeDevice();
+         }
+         catch( const exception &e )
+         {
+            LOG_ERROR( e.what() );
+            return EXIT_FAILURE;
+         }
+      #endif
    }
 
+   /* -b, -j and -l may come anywhere after the port. */
+   bool autoBaud( false );
+   bool lowLatency( false );
+   string journal;
+   vector< string > args;
+   for( int i( first ); i < argc; i ++ )
+      if( string( argv[i] ) == "-b" )
+         autoBaud = true;
+      else if( string( argv[i] ) == "-j" && i + 1 < argc )
+         journal = argv[++ i];
+      else if( string( argv[i] ) == "-l" )
+         lowLatency = true;
+      else
+         args.push_back( argv[i] );
+
    string port(  arg1 );
    ulong  speed( SERIAL_SPEED );
-   if( argc > 2 )
-      speed = stringTo< ulong >( argv[2], SERIAL_SPEED );
+   if( args.size() > 0 )
+      speed = stringTo< ulong >( args[0], SERIAL_SPEED );
+   if( autoBaud )
+      speed = 0;
+   ulong  period( SLEEP_MILLIS );
+   if( args.size() > 1 )
+      period = stringTo< ulong >( args[1], SLEEP_MILLIS );
 
    int retCode( EXIT_FAILURE );
 
@@ -70,8 +160,21 @@ int _tmain( int argc, char* argv[] )
    else
       try
       {
+#if !defined( _WIN32 )
+         /* play the capture on a virtual port, the first number is how
+            many times faster, 0 as fast as it's read. */
+         if( !replay.empty() )
+         {
+            _replay = new serial::Replay( replay,
+               args.size() > 0 ? stringTo< double >( args[0], 1.0 ) : 1.0 );
+            port  = _replay->getPort();
+            speed = _replay->getBaudrate();
+            _replay->start( REPLAY_DELAY_MILLIS );
+            LOG_INFO( "Replaying " << replay << " on " << port << "." );
+         }
+#endif
          _import = new WeeditImport();
-         _import->start( port, speed );
+         _import->start( port, speed, period, lowLatency, journal );
       }
       catch( const exception &e )
       {
@@ -16,8 +16,14 @@
 #include <cstdio>
 #include <cstdarg>
 #include <cstdlib>
+#include <climits>
+#include <ctime>
 
 #include <glob.h>
+#include <fnmatch.h>
+#include <poll.h>
+#include <errno.h>
+#include <sys/inotify.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -25,6 +31,8 @@
 #include "xSerial.h"
 
 using serial::PortInfo;
+using serial::PortWatcher;
+using serial::IOException;
 using std::istringstream;
 using std::ifstream;
 using std::getline;
@@ -43,6 +51,8 @@ static vector<string> get_sysfs_info(const string& device_path);
 static string read_line(const string& file);
 static string usb_sysfs_hw_string(const string& sysfs_path);
 static string format(const char* format, ...);
+static vector<string> port_globs();
+static PortInfo port_info(const string& device);
 
 vector<string>
 glob(const vector<string>& patterns)
@@ -294,11 +304,9 @@ usb_sysfs_hw_string(const string& sysfs_path)
     return format("USB VID:PID=%s:%s %s", vid.c_str(), pid.c_str(), serial_number.c_str() );
 }
 
-vector<PortInfo>
-serial::list_ports()
+vector<string>
+port_globs()
 {
-    vector<PortInfo> results;
-
     vector<string> search_globs;
     search_globs.push_back("/dev/ttyACM*");
     search_globs.push_back("/dev/ttyS*");
@@ -306,30 +314,188 @@ serial::list_ports()
     search_globs.push_back("/dev/tty.*");
     search_globs.push_back("/dev/cu.*");
 
-    vector<string> devices_found = glob( search_globs );
+    return search_globs;
+}
+
+PortInfo
+port_info(const string& device)
+{
+    vector<string> sysfs_info = get_sysfs_info( device );
+
+    PortInfo device_entry;
+    device_entry.port = device;
+    device_entry.description = sysfs_info[0];
+    device_entry.hardware_id = sysfs_info[1];
+
+    return device_entry;
+}
+
+vector<PortInfo>
+serial::list_ports()
+{
+    vector<PortInfo> results;
+
+    vector<string> devices_found = glob( port_globs() );
 
     vector<string>::iterator iter = devices_found.begin();
 
     while( iter != devices_found.end() )
     {
-        string device = *iter++;
+        results.push_back( port_info( *iter++ ) );
+    }
+
+    return results;
+}
+
+PortWatcher::PortWatcher()
+    : _fd(-1)
+{
+    // Watch first, a port plugged while listing then still shows up.
+    _fd = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+
+    if( _fd == -1 )
+        THROW( IOException, errno );
+
+    // sysfs sends no inotify events, the /dev nodes stand for the ports.
+    if( inotify_add_watch( _fd, "/dev",
+            IN_CREATE | IN_DELETE | IN_MOVED_TO | IN_MOVED_FROM ) == -1 )
+    {
+        int err = errno;
+        ::close( _fd );
+        THROW( IOException, err );
+    }
+
+    _ports = list_ports();
+}
+
+PortWatcher::~PortWatcher()
+{
+    ::close( _fd );
+}
+
+const vector<PortInfo>
+PortWatcher::ports() const
+{
+    return _ports;
+}
+
+const int
+PortWatcher::getFd() const
+{
+    return _fd;
+}
+
+const size_t
+PortWatcher::poll(Handler& handler, const uint32_t timeout)
+{
+    vector<string> patterns = port_globs();
+
+    size_t changes = 0;
+
+    // Other /dev nodes wake the poll too, keep waiting for a port.
+    struct timespec now;
+    clock_gettime( CLOCK_MONOTONIC, &now );
+
+    const int64_t deadline_ms = now.tv_sec * 1000LL + now.tv_nsec / 1000000
+                              + static_cast<int64_t>( timeout );
+
+    while( changes == 0 )
+    {
+        int wait_ms = -1;
+
+        if( timeout <= INT_MAX )
+        {
+            clock_gettime( CLOCK_MONOTONIC, &now );
+
+            int64_t left = deadline_ms - ( now.tv_sec * 1000LL + now.tv_nsec / 1000000 );
+
+            wait_ms = left > 0 ? static_cast<int>( left ) : 0;
+        }
+
+        changes += read_events( handler, patterns, wait_ms );
+
+        if( wait_ms == 0 )
+            break;
+    }
+
+    return changes;
+}
+
+const size_t
+PortWatcher::read_events(Handler& handler, const vector<string>& patterns, const int wait_ms)
+{
+    struct pollfd pfd;
+    pfd.fd = _fd;
+    pfd.events = POLLIN;
 
-        vector<string> sysfs_info = get_sysfs_info( device );
+    int r = ::poll( &pfd, 1, wait_ms );
 
-        string friendly_name = sysfs_info[0];
+    if( r == -1 && errno != EINTR )
+        THROW( IOException, errno );
 
-        string hardware_id = sysfs_info[1];
+    if( r <= 0 )
+        return 0;
 
-        PortInfo device_entry;
-        device_entry.port = device;
-        device_entry.description = friendly_name;
-        device_entry.hardware_id = hardware_id;
+    size_t changes = 0;
 
-        results.push_back( device_entry );
+    // Events are whole in a read, the buffer fits several long names.
+    char buffer[ 4096 ] __attribute__(( aligned( __alignof__( struct inotify_event ) ) ));
+
+    while( true )
+    {
+        ssize_t length = ::read( _fd, buffer, sizeof( buffer ) );
 
+        if( length == -1 && ( errno == EAGAIN || errno == EINTR ) )
+            break;
+
+        if( length <= 0 )
+            THROW( IOException, errno );
+
+        for( char* at = buffer; at < buffer + length; )
+        {
+            const struct inotify_event* event =
+                reinterpret_cast<const struct inotify_event*>( at );
+
+            at += sizeof( struct inotify_event ) + event->len;
+
+            if( event->len == 0 )
+                continue;
+
+            string device = string( "/dev/" ) + event->name;
+
+            bool wanted = false;
+
+            for( size_t i = 0; i < patterns.size() && !wanted; ++i )
+                wanted = fnmatch( patterns[i].c_str(), device.c_str(), 0 ) == 0;
+
+            if( !wanted )
+                continue;
+
+            vector<PortInfo>::iterator known = _ports.begin();
+
+            while( known != _ports.end() && known->port != device )
+                ++known;
+
+            if( event->mask & ( IN_CREATE | IN_MOVED_TO ) )
+            {
+                if( known != _ports.end() )
+                    continue;
+
+                _ports.push_back( port_info( device ) );
+                ++changes;
+                handler.onAdd( _ports.back() );
+            }
+            else if( known != _ports.end() )
+            {
+                PortInfo gone = *known;
+                _ports.erase( known );
+                ++changes;
+                handler.onRemove( gone );
+            }
+        }
     }
 
-    return results;
+    return changes;
 }
 
 #endif // defined(__linux__)
@@ -14,6 +14,7 @@
 //-----------------------------------------------------------------------------
 
 #include "xTypes.h"
+#include "xStringView.h"
 
 //-----------------------------------------------------------------------------
 
@@ -52,6 +53,11 @@ namespace xTools
       const ulong milis
       )  NOEXCEPTION;
 
+   /* monotonic milliseconds, only meaningful as a difference. */
+   const ulong
+      tickMillis()
+         NOEXCEPTION;
+
    const bool
       split(
       const string& STR,
@@ -114,27 +120,80 @@ namespace xTools
          }
 
    /*!
-    * EXCEPTION SAFE string to number cast.
+    * T from the start of STR through a stream, false if none.
+    */
+   template< typename T >
+      const bool
+         streamNumber(
+         const stringView& STR,
+               T&          val
+         )  NOEXCEPTION
+         {
+            std::istringstream is( string( STR.data(), STR.size() ) );
+            T val2;
+            is >> val2;
+            if( !is )
+               return false;
+            val = val2;
+            return true;
+         }
+
+   /*!
+    * A number from the start of STR, as the stream reads it: blanks
+    * skipped, the rest of STR ignored. Plain decimals are converted
+    * here, with no stream and no allocation; anything else, and any T
+    * without an overload, goes through streamNumber.
+    */
+   const bool parseNumber( const stringView& STR, int&    val ) NOEXCEPTION;
+   const bool parseNumber( const stringView& STR, long&   val ) NOEXCEPTION;
+   const bool parseNumber( const stringView& STR, uint&   val ) NOEXCEPTION;
+   const bool parseNumber( const stringView& STR, ulong&  val ) NOEXCEPTION;
+   const bool parseNumber( const stringView& STR, float&  val ) NOEXCEPTION;
+   const bool parseNumber( const stringView& STR, double& val ) NOEXCEPTION;
+
+   template< typename T >
+      const bool
+         parseNumber(
+         const stringView& STR,
+               T&          val
+         )  NOEXCEPTION
+         {
+            return streamNumber( STR, val );
+         }
+
+   /*!
+    * EXCEPTION SAFE string to number cast, of a view.
     */
    template< typename T >
       const T
          stringTo(
-         const string& str,
-         const T       defVal
+         const stringView& str,
+         const T           defVal
          )  NOEXCEPTION
          {
             T val( defVal );
             if( !str.empty() )
             {
-               std::istringstream is( str );
                T val2;
-               is >> val2;
-               if( is )
+               if( parseNumber( str, val2 ) )
                   val = val2;
             }
             return val;
          }
 
+   /*!
+    * EXCEPTION SAFE string to number cast.
+    */
+   template< typename T >
+      const T
+         stringTo(
+         const string& str,
+         const T       defVal
+         )  NOEXCEPTION
+         {
+            return stringTo< T >( stringView( str ), defVal );
+         }
+
    /*!
     * EXCEPTION SAFE string to number cast.
     */
@@ -173,6 +232,7 @@ using xTools::folderExists;
 using xTools::createFolder;
 using xTools::fileExists;
 using xTools::xSleep;
+using xTools::tickMillis;
 using xTools::split;
 using xTools::parse;
 using xTools::toString;
@@ -0,0 +1,261 @@
+/*!
+** \file    xLineReader.cpp
+** \date    2026/10/17 08:00
+** \brief   xTools serial reader thread with a lock-free line queue, implementation.
+** \author  A.Godinho (Woody)
+**/
+
+#include "xLineReader.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+//-----------------------------------------------------------------------------
+
+namespace xTools
+{
+   /*
+    * Acquire loads and release stores of the ring indexes and counters.
+    * MSVC volatile accesses are already acquire/release (/volatile:ms).
+    */
+#if defined( _MSC_VER )
+#  define LOAD_ACQUIRE( var )          ( var )
+#  define STORE_RELEASE( var, value )  ( ( var ) = ( value ) )
+#else
+#  define LOAD_ACQUIRE( var )          __atomic_load_n( &( var ), __ATOMIC_ACQUIRE )
+#  define STORE_RELEASE( var, value )  __atomic_store_n( &( var ), ( value ), __ATOMIC_RELEASE )
+#endif
+
+   /* Smallest power of two not below N. */
+   static
+   const size_t
+      powerOfTwo(
+         const size_t N
+      )  NOEXCEPTION
+   {
+      size_t p( 1 );
+      while( p < N )
+         p <<= 1;
+      return p;
+   }
+
+   /* Thread entry, the platform signature around LineReader::loop. */
+   struct LineReaderThread
+   {
+#ifdef _WIN32
+      static DWORD WINAPI
+         main( LPVOID reader )
+      {
+         static_cast< LineReader* >( reader )->loop();
+         return 0;
+      }
+#else
+      static void*
+         main( void* reader )
+      {
+         static_cast< LineReader* >( reader )->loop();
+         return NULL;
+      }
+#endif
+   };
+
+   LineReader::LineReader(
+      const size_t CAPACITY
+   ):
+      _ring(      powerOfTwo( CAPACITY ? CAPACITY : 1 ) ),
+      _MASK(      _ring.size() - 1 ),
+      _head(      0 ),
+      _highWater( 0 ),
+      _lines(     0 ),
+      _drops(     0 ),
+      _running(   false ),
+      _tail(      0 ),
+      _stop(      false ),
+      _port(      NULL ),
+      _size(      0 ),
+      _eol(       ),
+      _partial(   ),
+      _thread(    ),
+      _started(   false )
+   {
+      /* Nothing. */
+   }
+
+   LineReader::~LineReader()
+   {
+      stop();
+   }
+
+   void
+      LineReader::start(
+         serial::Serial& port,
+         const size_t    SIZE,
+         const string&   EOL
+      )
+   {
+      if( _started )
+         throw runtime_error( "Line reader already started!" );
+
+      _port = &port;
+      _size = SIZE;
+      _eol  = EOL;
+      _partial.clear();
+      _stop = false;
+      _running = true;
+
+#ifdef _WIN32
+      _thread = CreateThread( NULL, 0, LineReaderThread::main, this, 0, NULL );
+      _started = _thread != NULL;
+#else
+      _started = pthread_create( &_thread, NULL, LineReaderThread::main, this ) == 0;
+#endif
+      if( !_started )
+      {
+         _running = false;
+         throw runtime_error( "Can't start the reader thread!" );
+      }
+   }
+
+   void
+      LineReader::stop()
+         NOEXCEPTION
+   {
+      if( !_started )
+         return;
+
+      STORE_RELEASE( _stop, true );
+#ifdef _WIN32
+      WaitForSingleObject( _thread, INFINITE );
+      CloseHandle( _thread );
+#else
+      pthread_join( _thread, NULL );
+#endif
+      _started = false;
+   }
+
+   const bool
+      LineReader::pop(
+         stampedLine& line
+      )  NOEXCEPTION
+   {
+      const size_t TAIL( _tail );
+      if( TAIL == LOAD_ACQUIRE( _head ) )
+         return false;
+
+      /* swap, the slot keeps the old buffer for the reader to reuse. */
+      stampedLine& slot( _ring[ TAIL & _MASK ] );
+      line.tick = slot.tick;
+      line.text.swap( slot.text );
+      STORE_RELEASE( _tail, TAIL + 1 );
+      return true;
+   }
+
+   const size_t
+      LineReader::depth() const
+         NOEXCEPTION
+   {
+      return LOAD_ACQUIRE( _head ) - LOAD_ACQUIRE( _tail );
+   }
+
+   const size_t
+      LineReader::highWater() const
+         NOEXCEPTION
+   {
+      return LOAD_ACQUIRE( _highWater );
+   }
+
+   const ulong
+      LineReader::lines() const
+         NOEXCEPTION
+   {
+      return LOAD_ACQUIRE( _lines );
+   }
+
+   const ulong
+      LineReader::drops() const
+         NOEXCEPTION
+   {
+      return LOAD_ACQUIRE( _drops );
+   }
+
+   const bool
+      LineReader::running() const
+         NOEXCEPTION
+   {
+      return LOAD_ACQUIRE( _running );
+   }
+
+   void
+      LineReader::push(
+         string& text
+      )  NOEXCEPTION
+   {
+      const ulong TICK( tickMillis() );
+      const size_t HEAD( _head );
+      const size_t DEPTH( HEAD - LOAD_ACQUIRE( _tail ) );
+      STORE_RELEASE( _lines, _lines + 1 );
+      if( DEPTH == _ring.size() )
+      {
+         STORE_RELEASE( _drops, _drops + 1 );
+         text.clear();
+         return;
+      }
+
+      stampedLine& slot( _ring[ HEAD & _MASK ] );
+      slot.tick = TICK;
+      slot.text.swap( text );
+      text.clear();
+      STORE_RELEASE( _head, HEAD + 1 );
+      if( DEPTH + 1 > _highWater )
+         STORE_RELEASE( _highWater, DEPTH + 1 );
+   }
+
+   void
+      LineReader::loop()
+   {
+      const size_t EOL_LEN( _eol.length() );
+      try
+      {
+         while( !LOAD_ACQUIRE( _stop ) )
+         {
+            /* a timeout returns what arrived so far, or nothing. */
+            const stringView VIEW( _port->readline_view( _size - _partial.length(), _eol ) );
+            if( VIEW.empty() )
+               continue;
+            const size_t HELD( _partial.length() );
+            _partial.append( VIEW.data(), VIEW.size() );
+
+            /*
+             * an EOL cut by the timeout ends inside the view, not at its
+             * end, so queue every line _partial now completes.
+             */
+            size_t from( HELD >= EOL_LEN ? HELD - EOL_LEN + 1 : 0 );
+            size_t at;
+            while( EOL_LEN && ( at = _partial.find( _eol, from ) ) != string::npos )
+            {
+               const size_t END( at + EOL_LEN );
+               if( END == _partial.length() )
+               {
+                  push( _partial );
+                  break;
+               }
+               string rest( _partial, END );
+               _partial.erase( END );
+               push( _partial );
+               _partial.swap( rest );
+               from = 0;
+            }
+            if( !EOL_LEN || _partial.length() >= _size )
+               push( _partial );
+         }
+      }
+      catch( const exception& e )
+      {
+         LOG_ERROR( "Reader thread stopped, " << e.what() );
+      }
+      STORE_RELEASE( _running, false );
+   }
+}
+
+// EOF.
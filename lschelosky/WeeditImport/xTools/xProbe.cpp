@@ -0,0 +1,148 @@
+/*!
+** \file    xProbe.cpp
+** \date    2026/10/17 08:00
+** \brief   xTools concurrent serial port probe, implementation.
+** \author  A.Godinho (Woody)
+**/
+
+#include "xProbe.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+//-----------------------------------------------------------------------------
+
+namespace xTools
+{
+   /* One port under probe, written by its own thread only. */
+   struct probeJob
+   {
+      string                        port;
+      const vector< probeSpec >*    specs;
+      string                        found;   /* spec name, empty if none. */
+   };
+
+   /* Does PORT answer as SPEC within its dwell. */
+   static
+   const bool
+      probeOne(
+         const string&     PORT,
+         const probeSpec&  SPEC
+      )
+   {
+      const ulong START( tickMillis() );
+      serial::Serial port;
+      port.setPort( PORT );
+      port.setBaudrate( SPEC.baudrate );
+      port.setTimeout( serial::Timeout::simpleTimeout( SPEC.millis ) );
+      port.open();
+      port.flushInput();
+      if( !SPEC.request.empty() )
+         port.write( SPEC.request );
+
+      /* noise at the wrong rate reads as short garbage lines. */
+      ulong elapsed( 0 );
+      while( ( elapsed = tickMillis() - START ) < SPEC.millis )
+      {
+         port.setTimeout( serial::Timeout::simpleTimeout( SPEC.millis - elapsed ) );
+         const string LINE( port.readline( 256, SPEC.eol ) );
+         if( LINE.find( SPEC.match ) != string::npos )
+            return true;
+      }
+      return false;
+   }
+
+   /* Thread body, tries the specs in order. */
+   static
+   void
+      probeRun(
+         probeJob& job
+      )
+   {
+      for( size_t i( 0 ); i < job.specs->size() && job.found.empty(); i ++ )
+      {
+         try
+         {
+            if( probeOne( job.port, ( *job.specs )[ i ] ) )
+               job.found = ( *job.specs )[ i ].name;
+         }
+         catch( const exception& e )
+         {
+            /* busy, gone or not a serial port at all. */
+            LOG_DEBUG( "Probe " << job.port << " skipped, " << e.what() );
+            return;
+         }
+      }
+   }
+
+   /* Thread entry, the platform signature around probeRun. */
+#ifdef _WIN32
+   static DWORD WINAPI
+      probeMain( LPVOID job )
+   {
+      probeRun( *static_cast< probeJob* >( job ) );
+      return 0;
+   }
+#else
+   static void*
+      probeMain( void* job )
+   {
+      probeRun( *static_cast< probeJob* >( job ) );
+      return NULL;
+   }
+#endif
+
+   const stringMap
+      probePorts(
+         const stringVector&          PORTS,
+         const vector< probeSpec >&   SPECS
+      )
+   {
+      vector< probeJob > jobs( PORTS.size() );
+#ifdef _WIN32
+      vector< HANDLE > threads( PORTS.size(), ( HANDLE )NULL );
+#else
+      vector< pthread_t > threads( PORTS.size() );
+      vector< bool > started( PORTS.size(), false );
+#endif
+
+      for( size_t i( 0 ); i < PORTS.size(); i ++ )
+      {
+         jobs[ i ].port = PORTS[ i ];
+         jobs[ i ].specs = &SPECS;
+#ifdef _WIN32
+         threads[ i ] = CreateThread( NULL, 0, probeMain, &jobs[ i ], 0, NULL );
+         if( threads[ i ] == NULL )
+            probeRun( jobs[ i ] );
+#else
+         started[ i ] = pthread_create( &threads[ i ], NULL, probeMain, &jobs[ i ] ) == 0;
+         if( !started[ i ] )
+            probeRun( jobs[ i ] );
+#endif
+      }
+
+      stringMap found;
+      for( size_t i( 0 ); i < PORTS.size(); i ++ )
+      {
+#ifdef _WIN32
+         if( threads[ i ] != NULL )
+         {
+            WaitForSingleObject( threads[ i ], INFINITE );
+            CloseHandle( threads[ i ] );
+         }
+#else
+         if( started[ i ] )
+            pthread_join( threads[ i ], NULL );
+#endif
+         /* the first port wins when a device type shows twice. */
+         if( !jobs[ i ].found.empty() && found.find( jobs[ i ].found ) == found.end() )
+            found[ jobs[ i ].found ] = jobs[ i ].port;
+      }
+      return found;
+   }
+}
+
+// EOF.
@@ -15,21 +15,19 @@
 **/
 
 #include <algorithm>
-
-#if !defined( _WIN32 ) && !defined( __OpenBSD__ ) && !defined( __FreeBSD__ )
-#include <alloca.h>
-#endif
-
-#if defined( __MINGW32__ )
-#define alloca __builtin_alloca
-#endif
+#include <cctype>
+#include <cerrno>
+#include <cstring>
 
 #include "xSerial.h"
+#include "xScan.h"
 
 #if defined( _WIN32 )
 #include "xSerialImpl-win.h"
 #else
 #include "xSerialImpl-unix.h"
+#include <time.h>
+#include <unistd.h>
 #endif
 
 using std::invalid_argument;
@@ -46,6 +44,24 @@ using serial::bytesize_t;
 using serial::parity_t;
 using serial::stopbits_t;
 using serial::flowcontrol_t;
+using serial::transport_t;
+using serial::Reconnect;
+using serial::PortInfo;
+using serial::Journal;
+
+/* PortWatcher is built in, by_serial_number can follow a port. */
+#if defined( __linux__ ) && defined( USE_SERIAL_ENUM )
+#define SERIAL_FIND_BY_ID
+#endif
+
+/* _lost is read without the locks, writes test it before locking. */
+#if defined( _MSC_VER )
+#define LOAD_ACQUIRE( var )          ( var )
+#define STORE_RELEASE( var, value )  ( ( var ) = ( value ) )
+#else
+#define LOAD_ACQUIRE( var )          __atomic_load_n( &( var ), __ATOMIC_ACQUIRE )
+#define STORE_RELEASE( var, value )  __atomic_store_n( &( var ), ( value ), __ATOMIC_RELEASE )
+#endif
 
 /* disable 'strncopy' unsafe warning. */
 #pragma warning( disable : 4996 )
@@ -87,6 +103,110 @@ private:
   SerialImpl *_pimpl;
 };
 
+/*
+ * Receive buffer. Bytes are pulled from the port in chunks of whatever the
+ * driver already holds, and lines are cut out of it with memchr instead of
+ * one read per byte. Consumed space is reclaimed by moving the pending tail
+ * back to the front, so a line is always contiguous for memchr / memcmp.
+ */
+class Serial::ReadBuffer {
+public:
+  ReadBuffer() : _head( 0 ), _tail( 0 ) {}
+
+  /* Number of bytes held, not yet consumed. */
+  const size_t
+    size() const
+  {
+    return _tail - _head;
+  }
+
+  /* First byte held. */
+  const uint8_t*
+    data() const
+  {
+    return _buf.empty() ? NULL : &_buf[ 0 ] + _head;
+  }
+
+  /* Drop the first count bytes held. */
+  void
+    consume( const size_t count )
+  {
+    _head += count;
+    if( _head == _tail )
+      _head = _tail = 0;
+  }
+
+  void
+    clear()
+  {
+    _head = _tail = 0;
+  }
+
+  /* Make room for count more bytes, return where to write them. */
+  uint8_t*
+    reserve( const size_t count )
+  {
+    if( _tail + count > _buf.size() )
+    {
+      if( _head )
+      {
+        memmove( &_buf[ 0 ], &_buf[ 0 ] + _head, _tail - _head );
+        _tail -= _head;
+        _head = 0;
+      }
+      if( _tail + count > _buf.size() )
+        _buf.resize( _tail + count );
+    }
+    return &_buf[ 0 ] + _tail;
+  }
+
+  /* Account count bytes written after reserve. */
+  void
+    commit( const size_t count )
+  {
+    _tail += count;
+  }
+
+  /* Move up to count held bytes into out. */
+  const size_t
+    copy( uint8_t *out, const size_t count )
+  {
+    const size_t n( min( count, size() ) );
+    if( n )
+    {
+      memcpy( out, data(), n );
+      consume( n );
+    }
+    return n;
+  }
+
+  /*
+   * Offset of the first eol starting at or after from and ending before
+   * limit, string::npos when there is none. An empty eol matches after
+   * the first byte, as the byte-wise loop did.
+   */
+  const size_t
+    find( const string &eol, const size_t from, const size_t limit ) const
+  {
+    if( eol.empty() )
+      return limit ? 1 : string::npos;
+    /* npos and the scanner's miss are both size_t( -1 ). */
+    return xTools::findEol( data(), limit, eol.data(), eol.length(), from );
+  }
+
+private:
+  /* Disable copy constructors. */
+  ReadBuffer( const ReadBuffer& );
+  const ReadBuffer& operator = (ReadBuffer);
+
+  vector< uint8_t > _buf;
+  size_t            _head;
+  size_t            _tail;
+};
+
+/* Largest chunk pulled from the port by a single fill. */
+static const size_t READ_CHUNK_SIZE( 4096 );
+
 Serial::Serial(
   const string&          port,
   const uint32_t         baudrate,
@@ -99,13 +219,27 @@ Serial::Serial(
   _pimpl( new SerialImpl( 
      port, baudrate, 
      bytesize, parity, stopbits, flowcontrol
-  ))
+  )),
+  _rxbuf( new ReadBuffer() ),
+  _stats(),
+  _reconnect(),
+  _lost( false ),
+  _delay( 0 ),
+  _retry_tick( 0 ),
+  _hardware_id(),
+  _watcher( NULL ),
+  _capture( NULL )
 {
   _pimpl->setTimeout( timeout );
 }
 
 Serial::~Serial()
 {
+#if defined( SERIAL_FIND_BY_ID )
+  delete _watcher;
+#endif
+  delete _capture;
+  delete _rxbuf;
   delete _pimpl;
 }
 
@@ -113,12 +247,17 @@ void
 Serial::open()
 {
   _pimpl->open();
+  _stats = Statistics();
+  STORE_RELEASE( _lost, false );
+  _identify();
 }
 
 void
 Serial::close()
 {
   _pimpl->close();
+  _rxbuf->clear();
+  STORE_RELEASE( _lost, false );
 }
 
 const bool
@@ -130,12 +269,14 @@ Serial::isOpen() const
 const size_t
 Serial::available()
 {
-  return _pimpl->available();
+  return _rxbuf->size() + _pimpl->available();
 }
 
 const bool
 Serial::waitReadable()
 {
+  if( _rxbuf->size() )
+    return true;
   serial::Timeout timeout( _pimpl->getTimeout() );
   return _pimpl->waitReadable( timeout.read_timeout_constant );
 }
@@ -149,14 +290,509 @@ Serial::waitByteTimes( const size_t count )
 const size_t
 Serial::_read( uint8_t *buffer, const size_t size )
 {
-  return this->_pimpl->read( buffer, size );
+  const size_t bytes_held( _rxbuf->copy( buffer, size ) );
+  if( bytes_held == size )
+    return bytes_held;
+  if( LOAD_ACQUIRE( _lost ) && !this->_reopen( _pimpl->getTimeout().read_timeout_constant ) )
+  {
+    ++_stats.timeouts;
+    return bytes_held;
+  }
+  size_t bytes_read( 0 );
+  try
+  {
+    bytes_read = this->_pimpl->read( buffer + bytes_held, size - bytes_held );
+    if( _capture )
+      _capture->record( Journal::received, buffer + bytes_held, bytes_read );
+  }
+  catch( const SerialException& )
+  {
+    if( !this->_lose() ) throw;
+  }
+  catch( const IOException& )
+  {
+    if( !this->_lose() ) throw;
+  }
+  _stats.bytes_read += bytes_read;
+  if( bytes_held + bytes_read < size )
+    ++_stats.timeouts;
+  return bytes_held + bytes_read;
+}
+
+const size_t
+Serial::_fill( const size_t size )
+{
+  if( LOAD_ACQUIRE( _lost ) && !this->_reopen( _pimpl->getTimeout().read_timeout_constant ) )
+    return 0;
+  try
+  {
+    if( _pimpl->getTransport() == transport_streaming )
+    {
+      /* The kernel holds the read for a whole batch, no FIONREAD first. */
+      const size_t count( min( size, READ_CHUNK_SIZE ) );
+      uint8_t *chunk( _rxbuf->reserve( count ) );
+      const size_t bytes_read( this->_pimpl->readBatch( chunk, count ) );
+      if( _capture )
+        _capture->record( Journal::received, chunk, bytes_read );
+      _rxbuf->commit( bytes_read );
+      _stats.bytes_read += bytes_read;
+      return bytes_read;
+    }
+
+    /* Take whatever the driver holds; when it holds nothing, block for the
+     * next byte so the read timeout applies exactly as before. */
+    size_t count( min( _pimpl->available(), min( size, READ_CHUNK_SIZE ) ) );
+    if( count == 0 )
+      count = 1;
+    uint8_t *chunk( _rxbuf->reserve( count ) );
+    const size_t bytes_read( this->_pimpl->read( chunk, count ) );
+    if( _capture )
+      _capture->record( Journal::received, chunk, bytes_read );
+    _rxbuf->commit( bytes_read );
+    _stats.bytes_read += bytes_read;
+    return bytes_read;
+  }
+  catch( const SerialException& )
+  {
+    if( !this->_lose() ) throw;
+  }
+  catch( const IOException& )
+  {
+    if( !this->_lose() ) throw;
+  }
+  /* What the buffer holds is read first, a cut line as a timeout. */
+  return 0;
+}
+
+#if defined( SERIAL_FIND_BY_ID )
+/* Takes the first added port with the wanted USB id. */
+class ReattachHandler : public serial::PortWatcher::Handler
+{
+public:
+  ReattachHandler( const string &hardware_id, string &port ):
+    _hardware_id( hardware_id ),
+    _port( port )
+  {
+    /* Nothing. */
+  }
+
+  virtual void
+    onAdd( const PortInfo &port )
+  {
+    if( _port.empty() && port.hardware_id == _hardware_id )
+      _port = port.port;
+  }
+
+private:
+  const string &_hardware_id;
+  string       &_port;
+};
+
+/* The port with HARDWARE_ID in the table, empty if none. */
+static const string
+findPort( const vector< PortInfo > &ports, const string &hardware_id )
+{
+  for( size_t i( 0 ); i < ports.size(); ++i )
+    if( ports[ i ].hardware_id == hardware_id )
+      return ports[ i ].port;
+  return string();
+}
+#endif
+
+/* Millisecond tick for the reconnect backoff, wraps around. */
+static uint32_t
+reconnectTick()
+{
+#if defined( _WIN32 )
+  return GetTickCount();
+#else
+  timespec now;
+  clock_gettime( CLOCK_MONOTONIC, &now );
+  return uint32_t( now.tv_sec * 1000 + now.tv_nsec / 1000000 );
+#endif
+}
+
+static void
+reconnectSleep( const uint32_t millis )
+{
+#if defined( _WIN32 )
+  Sleep( millis );
+#else
+  usleep( useconds_t( millis ) * 1000 );
+#endif
+}
+
+const bool
+Serial::_lose()
+{
+  if( _reconnect.max_delay == 0 )
+    return false;
+  /* Called under the read lock, a write in progress must end first. */
+  ScopedWriteLock lock( this->_pimpl );
+  try
+  {
+    /* Keep the kernel error counts of this open, the next starts at 0. */
+    _pimpl->getErrorCounters( _stats );
+  }
+  catch( ... )
+  {
+  }
+  try
+  {
+    _pimpl->close();
+  }
+  catch( ... )
+  {
+  }
+  STORE_RELEASE( _lost, true );
+  _delay = std::max( _reconnect.initial_delay, uint32_t( 1 ) );
+  _retry_tick = reconnectTick() + _reconnect.initial_delay;
+  return true;
+}
+
+const bool
+Serial::_reopen( const uint32_t timeout )
+{
+  /* A zero timeout would retry in a busy loop, wait a backoff step. */
+  const uint32_t wait( timeout ? timeout : _delay );
+#if defined( SERIAL_FIND_BY_ID )
+  if( _watcher )
+    return this->_reattach( wait );
+#endif
+
+  const int32_t left( int32_t( _retry_tick - reconnectTick() ) );
+  if( left > 0 )
+  {
+    if( uint32_t( left ) > wait )
+    {
+      reconnectSleep( wait );
+      return false;
+    }
+    reconnectSleep( uint32_t( left ) );
+  }
+
+  ScopedWriteLock lock( this->_pimpl );
+  try
+  {
+    if( _pimpl->isOpen() )
+      _pimpl->close();
+    _pimpl->open();
+  }
+  catch( ... )
+  {
+  }
+
+  if( !_pimpl->isOpen() )
+  {
+    _retry_tick = reconnectTick() + _delay;
+    _delay = std::min( _delay * 2, std::max( _reconnect.max_delay, _delay ) );
+    return false;
+  }
+  STORE_RELEASE( _lost, false );
+  ++_stats.reconnects;
+  return true;
+}
+
+#if defined( SERIAL_FIND_BY_ID )
+const bool
+Serial::_reattach( const uint32_t wait )
+{
+  /* The backoff only follows a failed open, udev may still own the node. */
+  const int32_t left( int32_t( _retry_tick - reconnectTick() ) );
+  if( left > 0 )
+  {
+    if( uint32_t( left ) > wait )
+    {
+      reconnectSleep( wait );
+      return false;
+    }
+    reconnectSleep( uint32_t( left ) );
+  }
+
+  /* Catch up on the unplug, then look the adapter up; no rescan. */
+  string port;
+  ReattachHandler handler( _hardware_id, port );
+  try
+  {
+    _watcher->poll( handler, 0 );
+    port = findPort( _watcher->ports(), _hardware_id );
+    if( port.empty() )
+      _watcher->poll( handler, wait );
+  }
+  catch( ... )
+  {
+    reconnectSleep( wait );
+  }
+  if( port.empty() )
+    return false;
+
+  ScopedWriteLock lock( this->_pimpl );
+  try
+  {
+    if( _pimpl->isOpen() )
+      _pimpl->close();
+    if( port != _pimpl->getPort() )
+      _pimpl->setPort( port );
+    _pimpl->open();
+  }
+  catch( ... )
+  {
+  }
+
+  if( !_pimpl->isOpen() )
+  {
+    _retry_tick = reconnectTick() + _delay;
+    _delay = std::min( _delay * 2, std::max( _reconnect.max_delay, _delay ) );
+    return false;
+  }
+  STORE_RELEASE( _lost, false );
+  ++_stats.reconnects;
+  return true;
+}
+#endif
+
+void
+Serial::_identify()
+{
+  _hardware_id.clear();
+#if defined( SERIAL_FIND_BY_ID )
+  if( _reconnect.by_serial_number )
+  {
+    try
+    {
+      /* One scan, the watcher keeps the table current from then on. */
+      if( !_watcher )
+        _watcher = new serial::PortWatcher();
+      serial::PortWatcher::Handler ignore;
+      _watcher->poll( ignore, 0 );
+
+      /* Only ids with a serial number tell two equal adapters apart. */
+      const vector< PortInfo > ports( _watcher->ports() );
+      for( size_t i( 0 ); i < ports.size(); ++i )
+        if( ports[ i ].port == _pimpl->getPort() &&
+            ports[ i ].hardware_id.find( "SNR=" ) != string::npos )
+          _hardware_id = ports[ i ].hardware_id;
+    }
+    catch( ... )
+    {
+    }
+  }
+  if( _hardware_id.empty() )
+  {
+    delete _watcher;
+    _watcher = NULL;
+  }
+#endif
+}
+
+const size_t
+Serial::_scanline( const size_t size, const string &eol, bool &timeout )
+{
+  const size_t eol_len( eol.length() );
+  size_t scanned( 0 );
+  timeout = false;
+  while( true )
+  {
+    const size_t limit( min( _rxbuf->size(), size ) );
+    const size_t found( _rxbuf->find( eol, scanned, limit ) );
+    if( found != string::npos )
+    {
+      return found + eol_len; /* EOL found. */
+    }
+    if( limit == size )
+    {
+      return size; /* Reached the maximum read length. */
+    }
+    /* Bytes before this offset can't start an EOL any more. */
+    scanned = limit < eol_len ? 0 : limit - eol_len + 1;
+    if( this->_fill( size - limit ) == 0 )
+    {
+      ++_stats.timeouts;
+      timeout = true;
+      return limit; /* Timeout occured waiting for the next byte. */
+    }
+  }
+}
+
+#if defined( __linux__ )
+
+const size_t
+Serial::_drain()
+{
+  ScopedReadLock lock( this->_pimpl );
+  const size_t count( _pimpl->available() );
+  if( count == 0 )
+  {
+    /* Disconnected devices poll readable but hold no data. */
+    throw SerialException( "device reports readiness to read but "
+                           "returned no data (device disconnected?)" );
+  }
+  uint8_t *chunk( _rxbuf->reserve( count ) );
+  const size_t bytes_read( this->_pimpl->read( chunk, count ) );
+  if( _capture )
+    _capture->record( Journal::received, chunk, bytes_read );
+  _rxbuf->commit( bytes_read );
+  _stats.bytes_read += bytes_read;
+  return bytes_read;
+}
+
+const bool
+Serial::_popline( string &line, const size_t size, const string &eol,
+                  const bool partial )
+{
+  ScopedReadLock lock( this->_pimpl );
+  if( partial )
+    ++_stats.timeouts;
+  const size_t limit( min( _rxbuf->size(), size ) );
+  const size_t found( _rxbuf->find( eol, 0, limit ) );
+  size_t line_len( 0 );
+  if( found != string::npos )
+    line_len = found + eol.length();
+  else if( limit == size || partial )
+    line_len = limit;
+  if( line_len == 0 )
+    return false;
+  line.assign( reinterpret_cast< const char* >( _rxbuf->data() ), line_len );
+  _countLine( _rxbuf->data(), line_len, eol );
+  _rxbuf->consume( line_len );
+  return true;
 }
 
+const size_t
+Serial::_trywrite( const uint8_t *data, const size_t length )
+{
+  ScopedWriteLock lock( this->_pimpl );
+  const size_t bytes_written( this->_pimpl->writeSome( data, length ) );
+  if( _capture )
+    _capture->record( Journal::sent, data, bytes_written );
+  _stats.bytes_written += bytes_written;
+  return bytes_written;
+}
+
+const int
+Serial::_fd() const
+{
+  return _pimpl->getFd();
+}
+
+#endif
+
+#if defined( XTOOLS_COROUTINES )
+
+Serial::ReadlineAwaiter::ReadlineAwaiter( Serial &serial, const string &eol,
+                                          const uint32_t timeout,
+                                          const size_t size )
+: EventLoop::Waiter( serial._fd(), false, timeout ),
+  _serial( serial ),
+  _eol( eol ),
+  _size( size )
+{
+}
+
+const bool
+Serial::ReadlineAwaiter::await_ready()
+{
+  /* A line left over in the receive buffer needs no wait. */
+  return _serial._popline( _line, _size, _eol );
+}
+
+const bool
+Serial::ReadlineAwaiter::ready()
+{
+  try
+  {
+    _serial._drain();
+  }
+  catch( ... )
+  {
+    _error = std::current_exception();
+    return true;
+  }
+  return _serial._popline( _line, _size, _eol );
+}
+
+void
+Serial::ReadlineAwaiter::expire()
+{
+  _serial._popline( _line, _size, _eol, true );
+}
+
+const string
+Serial::ReadlineAwaiter::await_resume()
+{
+  if( _error )
+    std::rethrow_exception( _error );
+  return _line;
+}
+
+Serial::WriteAwaiter::WriteAwaiter( Serial &serial, const string &data,
+                                    const uint32_t timeout )
+: EventLoop::Waiter( serial._fd(), true, timeout ),
+  _serial( serial ),
+  _data( data ),
+  _written( 0 )
+{
+}
+
+const bool
+Serial::WriteAwaiter::await_ready()
+{
+  return ready();
+}
+
+const bool
+Serial::WriteAwaiter::ready()
+{
+  try
+  {
+    _written += _serial._trywrite(
+      reinterpret_cast< const uint8_t* >( _data.data() ) + _written,
+      _data.size() - _written );
+  }
+  catch( ... )
+  {
+    _error = std::current_exception();
+    return true;
+  }
+  return _written == _data.size();
+}
+
+const size_t
+Serial::WriteAwaiter::await_resume()
+{
+  if( _error )
+    std::rethrow_exception( _error );
+  return _written;
+}
+
+Serial::ReadlineAwaiter
+Serial::async_readline( const string &eol, const uint32_t timeout,
+                        const size_t size )
+{
+  if( !isOpen() )
+    throw PortNotOpenedException( "Serial::async_readline" );
+  if( getTransport() != transport_default )
+    throw invalid_argument( "async_readline needs the default transport" );
+  return ReadlineAwaiter( *this, eol, timeout, size );
+}
+
+Serial::WriteAwaiter
+Serial::async_write( const string &data, const uint32_t timeout )
+{
+  if( !isOpen() )
+    throw PortNotOpenedException( "Serial::async_write" );
+  if( getTransport() != transport_default )
+    throw invalid_argument( "async_write needs the default transport" );
+  return WriteAwaiter( *this, data, timeout );
+}
+
+#endif
+
 const size_t
 Serial::read( uint8_t *buffer, const size_t size )
 {
   ScopedReadLock lock( this->_pimpl );
-  return this->_pimpl->read( buffer, size );
+  return this->_read( buffer, size );
 }
 
 const size_t
@@ -164,7 +800,7 @@ Serial::read( vector< uint8_t > &buffer, const size_t size )
 {
   ScopedReadLock lock( this->_pimpl );
   uint8_t *buffer_( new uint8_t[ size ] );
-  const size_t bytes_read( this->_pimpl->read( buffer_, size ) );
+  const size_t bytes_read( this->_read( buffer_, size ) );
   buffer.insert( buffer.end (), buffer_, buffer_ + bytes_read );
   delete[] buffer_;
   return bytes_read;
@@ -175,7 +811,7 @@ Serial::read ( string &buffer, const size_t size )
 {
   ScopedReadLock lock( this->_pimpl );
   uint8_t *buffer_( new uint8_t[ size ] );
-  const size_t bytes_read( this->_pimpl->read( buffer_, size ) );
+  const size_t bytes_read( this->_read( buffer_, size ) );
   buffer.append( reinterpret_cast< const char* >( buffer_ ), bytes_read );
   delete[] buffer_;
   return bytes_read;
@@ -193,29 +829,11 @@ const size_t
 Serial::readline( string &buffer, const size_t size, const string &eol )
 {
   ScopedReadLock lock( this->_pimpl );
-  const size_t eol_len( eol.length() );
-  uint8_t *buffer_( static_cast< uint8_t* >
-    ( alloca( size * sizeof( uint8_t ) ) ) );
-  size_t read_so_far( 0 );
-  while( true )
-  {
-    const size_t bytes_read( this->_read( buffer_ + read_so_far, 1 ) );
-    read_so_far += bytes_read;
-    if( bytes_read == 0 )
-    {
-      break; /* Timeout occured on reading 1 byte. */
-    }
-    if( string( reinterpret_cast< const char* >
-    ( buffer_ + read_so_far - eol_len ), eol_len ) == eol )
-    {
-      break; /* EOL found. */
-    }
-    if( read_so_far == size )
-    {
-      break; /* Reached the maximum read length. */
-    }
-  }
-  buffer.append( reinterpret_cast< const char* >( buffer_), read_so_far );
+  bool timeout;
+  const size_t read_so_far( this->_scanline( size, eol, timeout ) );
+  buffer.append( reinterpret_cast< const char* >( _rxbuf->data() ), read_so_far );
+  _countLine( _rxbuf->data(), read_so_far, eol );
+  _rxbuf->consume( read_so_far );
   return read_so_far;
 }
 
@@ -227,49 +845,58 @@ Serial::readline( const size_t size, const string &eol )
   return buffer;
 }
 
+const stringView
+Serial::readline_view( const size_t size, const string &eol )
+{
+  ScopedReadLock lock( this->_pimpl );
+  bool timeout;
+  const size_t read_so_far( this->_scanline( size, eol, timeout ) );
+  const stringView line(
+    reinterpret_cast< const char* >( _rxbuf->data() ), read_so_far );
+  _countLine( _rxbuf->data(), read_so_far, eol );
+  /* The bytes stay in place until the next fill reuses them. */
+  _rxbuf->consume( read_so_far );
+  return line;
+}
+
 vector< string >
 Serial::readlines( const size_t size, const string &eol )
 {
   ScopedReadLock lock( this->_pimpl );
   vector< string > lines;
-  const size_t eol_len( eol.length() );
-  uint8_t *buffer_( static_cast< uint8_t* >
-    (alloca( size * sizeof( uint8_t ) ) ) );
+  vector< size_t > ends;
   size_t read_so_far( 0 );
-  size_t start_of_line( 0 );
-  while( read_so_far < size )
+  bool timeout( false );
+  while( read_so_far < size && !timeout )
   {
-    const size_t bytes_read( this->_read( buffer_+read_so_far, 1 ) );
-    read_so_far += bytes_read;
-    if( bytes_read == 0 )
+    /* Every complete line already buffered, in one pass. */
+    ends.clear();
+    if( !eol.empty() && xTools::splitLines( _rxbuf->data(),
+          min( _rxbuf->size(), size - read_so_far ),
+          eol.data(), eol.length(), ends ) )
     {
-      if( start_of_line != read_so_far )
+      const char *base( reinterpret_cast< const char* >( _rxbuf->data() ) );
+      size_t start( 0 );
+      for( size_t i( 0 ); i < ends.size(); i ++ )
       {
-        lines.push_back(
-          string( reinterpret_cast< const char* >( buffer_ + start_of_line ),
-            read_so_far - start_of_line ) );
+        lines.push_back( string( base + start, ends[ i ] - start ) );
+        start = ends[ i ];
       }
-      break; /* Timeout occured on reading 1 byte. */
+      _rxbuf->consume( start );
+      _stats.lines += ends.size();
+      read_so_far += start;
+      continue;
     }
-    if( string( reinterpret_cast< const char* >
-    ( buffer_ + read_so_far - eol_len ), eol_len ) == eol )
+    const size_t line_len( this->_scanline( size - read_so_far, eol, timeout ) );
+    if( line_len == 0 )
     {
-      /* EOL found. */
-      lines.push_back(
-        string( reinterpret_cast< const char* >( buffer_ + start_of_line ),
-          read_so_far - start_of_line ) );
-      start_of_line = read_so_far;
-    }
-    if( read_so_far == size )
-    {
-      if( start_of_line != read_so_far )
-      {
-        lines.push_back(
-          string( reinterpret_cast< const char* >( buffer_ + start_of_line ),
-            read_so_far - start_of_line ) );
-      }
-      break; /* Reached the maximum read length. */
+      break; /* Timeout with nothing pending. */
     }
+    lines.push_back(
+      string( reinterpret_cast< const char* >( _rxbuf->data() ), line_len ) );
+    _countLine( _rxbuf->data(), line_len, eol );
+    _rxbuf->consume( line_len );
+    read_so_far += line_len;
   }
   return lines;
 }
@@ -277,7 +904,6 @@ Serial::readlines( const size_t size, const string &eol )
 const size_t
 Serial::write( const string &data )
 {
-  ScopedWriteLock lock( this->_pimpl );
   return this->_write( reinterpret_cast< const uint8_t* >
     ( data.c_str() ), data.length() );
 }
@@ -285,21 +911,72 @@ Serial::write( const string &data )
 const size_t
 Serial::write( const vector< uint8_t > &data )
 {
-  ScopedWriteLock lock( this->_pimpl );
   return this->_write( &data[0], data.size() );
 }
 
 const size_t
 Serial::write( const uint8_t *data, const size_t size )
 {
-  ScopedWriteLock lock( this->_pimpl );
   return this->_write( data, size );
 }
 
 const size_t
 Serial::_write( const uint8_t *data, const size_t length )
 {
-  return _pimpl->write( data, length );
+  if( LOAD_ACQUIRE( _lost ) )
+  {
+    /* Reopening takes the read lock first, as reads do. */
+    ScopedReadLock lock( this->_pimpl );
+    if( LOAD_ACQUIRE( _lost ) && !this->_reopen( _pimpl->getTimeout().write_timeout_constant ) )
+      return 0;
+  }
+
+  size_t bytes_written( 0 );
+  bool failed( false );
+  {
+    ScopedWriteLock lock( this->_pimpl );
+    try
+    {
+      bytes_written = _pimpl->write( data, length );
+      if( _capture )
+        _capture->record( Journal::sent, data, bytes_written );
+    }
+    catch( const SerialException& )
+    {
+      if( _reconnect.max_delay == 0 ) throw;
+      failed = true;
+    }
+    catch( const IOException& )
+    {
+      if( _reconnect.max_delay == 0 ) throw;
+      failed = true;
+    }
+    catch( const PortNotOpenedException& )
+    {
+      /* A read lost it since. */
+      if( _reconnect.max_delay == 0 ) throw;
+    }
+    _stats.bytes_written += bytes_written;
+  }
+
+  if( failed )
+  {
+    ScopedReadLock lock( this->_pimpl );
+    if( !LOAD_ACQUIRE( _lost ) )
+      this->_lose();
+  }
+  return bytes_written;
+}
+
+void
+Serial::_countLine( const uint8_t *data, const size_t len, const string &eol )
+{
+  const size_t eol_len( eol.length() );
+  if( eol_len && len >= eol_len &&
+      memcmp( data + len - eol_len, eol.data(), eol_len ) == 0 )
+    ++_stats.lines;
+  else if( len )
+    ++_stats.partial_lines;
 }
 
 void
@@ -390,16 +1067,232 @@ Serial::getFlowcontrol() const
   return _pimpl->getFlowcontrol();
 }
 
+void
+Serial::setTransport( const transport_t transport )
+{
+  ScopedReadLock rlock( this->_pimpl );
+  ScopedWriteLock wlock( this->_pimpl );
+  const bool was_open( _pimpl->isOpen() );
+  if( was_open ) close();
+  _pimpl->setTransport( transport );
+  if( was_open ) open();
+}
+
+const transport_t
+Serial::getTransport() const
+{
+  return _pimpl->getTransport();
+}
+
+void
+Serial::setLowLatency( const bool low_latency )
+{
+  _pimpl->setLowLatency( low_latency );
+}
+
+const bool
+Serial::getLowLatency() const
+{
+  return _pimpl->getLowLatency();
+}
+
+void
+Serial::setLatencyTimer( const uint32_t millis )
+{
+  _pimpl->setLatencyTimer( millis );
+}
+
+const uint32_t
+Serial::getLatencyTimer() const
+{
+  return _pimpl->getLatencyTimer();
+}
+
+const uint32_t
+Serial::getAdapterLatency() const
+{
+  return _pimpl->getAdapterLatency();
+}
+
+void
+Serial::setReconnect( const Reconnect &reconnect )
+{
+  ScopedReadLock rlock( this->_pimpl );
+  ScopedWriteLock wlock( this->_pimpl );
+  _reconnect = reconnect;
+  if( _pimpl->isOpen() )
+    _identify();
+}
+
+const Reconnect
+Serial::getReconnect() const
+{
+  return _reconnect;
+}
+
+const bool
+Serial::isReconnecting() const
+{
+  return LOAD_ACQUIRE( _lost );
+}
+
+void
+Serial::setCapture( const string &path )
+{
+  ScopedReadLock rlock( this->_pimpl );
+  ScopedWriteLock wlock( this->_pimpl );
+  delete _capture;
+  _capture = NULL;
+  if( path.empty() )
+    return;
+  Journal *capture( new Journal() );
+  try
+  {
+    capture->create( path, getBaudrate() );
+  }
+  catch( ... )
+  {
+    delete capture;
+    throw;
+  }
+  _capture = capture;
+}
+
+const int
+Serial::getCaptureError() const
+{
+  /* setCapture swaps _capture under both locks. */
+  ScopedWriteLock lock( this->_pimpl );
+  return _capture ? _capture->getError() : 0;
+}
+
+/* Hex digit value, -1 if none. */
+static int
+hexDigit( const char c )
+{
+  if( c >= '0' && c <= '9' ) return c - '0';
+  if( c >= 'A' && c <= 'F' ) return c - 'A' + 10;
+  if( c >= 'a' && c <= 'f' ) return c - 'a' + 10;
+  return -1;
+}
+
+/* Does [begin, end) frame as a whole message: a $ sentence whose *hh
+   matches the XOR of the bytes between $ and *, or a *XXX: reply. */
+static bool
+provenFrame( const char *begin, const char *end )
+{
+  const size_t length( end - begin );
+  if( length >= 5 && begin[0] == '*' && begin[4] == ':' )
+  {
+    for( size_t i( 1 ); i < 4; ++i )
+      if( !isalnum( static_cast< unsigned char >( begin[i] ) ) )
+        return false;
+    return true;
+  }
+  if( length < 4 || begin[0] != '$' )
+    return false;
+  uint8_t sum( 0 );
+  const char *p( begin + 1 );
+  while( p < end && *p != '*' )
+    sum ^= static_cast< uint8_t >( *p++ );
+  if( end - p < 3 )
+    return false;
+  const int high( hexDigit( p[1] ) ), low( hexDigit( p[2] ) );
+  return high >= 0 && low >= 0 && sum == ( high << 4 | low );
+}
+
+/* Score what a dwell window read at one rate: printable ASCII and line
+   ends for, anything else, what a wrong rate makes of the bits, against;
+   a $ start adds a little. proven is set by any provenFrame line. */
+static long
+framingScore( const string &data, bool &proven )
+{
+  long score( 0 );
+  const char *line( data.data() );
+  const char *end( data.data() + data.size() );
+  for( const char *p( line ); p < end; ++p )
+  {
+    const unsigned char c( *p );
+    if( c != '\r' && c != '\n' )
+    {
+      score += ( c >= 0x20 && c < 0x7F ) ? 1 : -4;
+      continue;
+    }
+    ++score;
+    if( p > line )
+    {
+      if( *line == '$' )
+        score += 8;
+      if( provenFrame( line, p ) )
+        proven = true;
+    }
+    line = p + 1;
+  }
+  return score;
+}
+
+const uint32_t
+Serial::detectBaudrate( const vector< uint32_t > &candidates,
+                        const uint32_t dwell, const string &probe )
+{
+  if( !isOpen() )
+    throw PortNotOpenedException( "Serial::detectBaudrate" );
+
+  const uint32_t original( getBaudrate() );
+  const Timeout timeout( getTimeout() );
+  /* an inter byte timeout skips the wait for a full read, see read. */
+  setTimeout( Timeout( dwell, dwell, 0, dwell, 0 ) );
+
+  uint32_t best( 0 );
+  long best_score( 0 );
+  try
+  {
+    for( size_t i( 0 ); i < candidates.size(); ++i )
+    {
+      setBaudrate( candidates[ i ] );
+      flushInput();
+      if( !probe.empty() )
+        write( probe );
+
+      /* one read, it returns at the end of the dwell, or when full. */
+      bool proven( false );
+      const long score( framingScore( read( READ_CHUNK_SIZE ), proven ) );
+      if( proven )
+      {
+        best = candidates[ i ];
+        break;
+      }
+      if( score > best_score )
+      {
+        best_score = score;
+        best = candidates[ i ];
+      }
+    }
+  }
+  catch( ... )
+  {
+    setTimeout( timeout );
+    throw;
+  }
+
+  setTimeout( timeout );
+  setBaudrate( best ? best : original );
+  flushInput();
+  return best;
+}
+
 void Serial::flush ()
 {
   ScopedReadLock rlock( this->_pimpl );
   ScopedWriteLock wlock( this->_pimpl );
+  _rxbuf->clear();
   _pimpl->flush();
 }
 
 void Serial::flushInput()
 {
   ScopedReadLock lock( this->_pimpl );
+  _rxbuf->clear();
   _pimpl->flushInput();
 }
 
@@ -422,6 +1315,7 @@ Serial::purge()
 {
    ScopedReadLock rlock( this->_pimpl );
    ScopedWriteLock lock( this->_pimpl );
+   _rxbuf->clear();
    _pimpl->purge();
 }
 
@@ -504,4 +1398,215 @@ Serial::getCD() const
   return _pimpl->getCD();
 }
 
+const serial::Statistics
+Serial::getStatistics() const
+{
+  ScopedReadLock rlock( this->_pimpl );
+  ScopedWriteLock wlock( this->_pimpl );
+  Statistics stats( _stats );
+  _pimpl->getErrorCounters( stats );
+  return stats;
+}
+
+/* Journal lock, records come from the read and the write side. */
+class Journal::Mutex
+{
+public:
+#if defined( _WIN32 )
+  Mutex() { InitializeCriticalSection( &_cs ); }
+  ~Mutex() { DeleteCriticalSection( &_cs ); }
+  void lock() { EnterCriticalSection( &_cs ); }
+  void unlock() { LeaveCriticalSection( &_cs ); }
+private:
+  CRITICAL_SECTION _cs;
+#else
+  Mutex() { pthread_mutex_init( &_mutex, NULL ); }
+  ~Mutex() { pthread_mutex_destroy( &_mutex ); }
+  void lock() { pthread_mutex_lock( &_mutex ); }
+  void unlock() { pthread_mutex_unlock( &_mutex ); }
+private:
+  pthread_mutex_t _mutex;
+#endif
+};
+
+static const char JOURNAL_MAGIC[] = "XSJ1";
+
+/* Monotonic microseconds, for the journal timestamps. */
+static uint64_t
+journalMicros()
+{
+#if defined( _WIN32 )
+  LARGE_INTEGER count, frequency;
+  QueryPerformanceCounter( &count );
+  QueryPerformanceFrequency( &frequency );
+  return uint64_t( count.QuadPart / frequency.QuadPart * 1000000 +
+    count.QuadPart % frequency.QuadPart * 1000000 / frequency.QuadPart );
+#else
+  timespec now;
+  clock_gettime( CLOCK_MONOTONIC, &now );
+  return uint64_t( now.tv_sec ) * 1000000 + now.tv_nsec / 1000;
+#endif
+}
+
+/* Encodes value at out, at most 10 bytes, returns how many. */
+static size_t
+putVarint( uint8_t *out, uint64_t value )
+{
+  size_t length( 0 );
+  while( value >= 0x80 )
+  {
+    out[ length++ ] = uint8_t( value & 0x7F ) | 0x80;
+    value >>= 7;
+  }
+  out[ length++ ] = uint8_t( value );
+  return length;
+}
+
+static bool
+getVarint( FILE *file, uint64_t &value )
+{
+  value = 0;
+  for( int shift( 0 ); shift < 64; shift += 7 )
+  {
+    const int c( fgetc( file ) );
+    if( c == EOF )
+      return false;
+    value |= uint64_t( c & 0x7F ) << shift;
+    if( !( c & 0x80 ) )
+      return true;
+  }
+  return false;
+}
+
+Journal::Journal()
+: _mutex( new Mutex() ),
+  _file( NULL ),
+  _baudrate( 0 ),
+  _last( 0 ),
+  _error( 0 )
+{
+}
+
+Journal::~Journal()
+{
+  close();
+  delete _mutex;
+}
+
+void
+Journal::create( const string &path, const uint32_t baudrate )
+{
+  close();
+  _file = fopen( path.c_str(), "wb" );
+  if( _file == NULL )
+    THROW( IOException, errno );
+  _baudrate = baudrate;
+  const uint8_t header[ 8 ] = {
+    uint8_t( JOURNAL_MAGIC[0] ), uint8_t( JOURNAL_MAGIC[1] ),
+    uint8_t( JOURNAL_MAGIC[2] ), uint8_t( JOURNAL_MAGIC[3] ),
+    uint8_t( baudrate ), uint8_t( baudrate >> 8 ),
+    uint8_t( baudrate >> 16 ), uint8_t( baudrate >> 24 )
+  };
+  if( fwrite( header, 1, sizeof( header ), _file ) != sizeof( header ) ||
+      fflush( _file ) != 0 )
+  {
+    const int error( errno );
+    close();
+    THROW( IOException, error );
+  }
+  _last = journalMicros();
+  _error = 0;
+}
+
+void
+Journal::open( const string &path )
+{
+  close();
+  _file = fopen( path.c_str(), "rb" );
+  if( _file == NULL )
+    THROW( IOException, errno );
+  uint8_t header[ 8 ];
+  if( fread( header, 1, sizeof( header ), _file ) != sizeof( header ) ||
+      memcmp( header, JOURNAL_MAGIC, 4 ) != 0 )
+  {
+    close();
+    THROW( IOException, "not a serial journal" );
+  }
+  _baudrate = uint32_t( header[4] ) | uint32_t( header[5] ) << 8 |
+              uint32_t( header[6] ) << 16 | uint32_t( header[7] ) << 24;
+}
+
+void
+Journal::close()
+{
+  if( _file != NULL )
+  {
+    fclose( _file );
+    _file = NULL;
+  }
+}
+
+const uint32_t
+Journal::getBaudrate() const
+{
+  return _baudrate;
+}
+
+void
+Journal::record( const direction_t direction, const uint8_t *data,
+                 const size_t size )
+{
+  if( size == 0 )
+    return;
+  _mutex->lock();
+  if( _file != NULL )
+  {
+    /* Flushed each time, a crash or a kill keeps every record. */
+    const uint64_t now( journalMicros() );
+    uint8_t header[ 1 + 10 + 10 ];
+    size_t length( 0 );
+    header[ length++ ] = uint8_t( direction );
+    length += putVarint( header + length, now - _last );
+    length += putVarint( header + length, size );
+    errno = 0;
+    if( fwrite( header, 1, length, _file ) != length ||
+        fwrite( data, 1, size, _file ) != size ||
+        fflush( _file ) != 0 )
+    {
+      /* Nothing may follow a cut record, next stops at it. */
+      _error = errno ? errno : EIO;
+      fclose( _file );
+      _file = NULL;
+    }
+    _last = now;
+  }
+  _mutex->unlock();
+}
+
+const int
+Journal::getError() const
+{
+  _mutex->lock();
+  const int error( _error );
+  _mutex->unlock();
+  return error;
+}
+
+const bool
+Journal::next( Record &record )
+{
+  if( _file == NULL )
+    return false;
+  const int direction( fgetc( _file ) );
+  uint64_t size;
+  if( direction == EOF ||
+      !getVarint( _file, record.delay ) || !getVarint( _file, size ) ||
+      size > READ_CHUNK_SIZE * 1024 )
+    return false;
+  record.direction = direction == sent ? sent : received;
+  record.data.resize( size_t( size ) );
+  return size == 0 ||
+    fread( &record.data[0], 1, size_t( size ), _file ) == size_t( size );
+}
+
 // EOF.
\ No newline at end of file
@@ -15,6 +15,7 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <stdlib.h>
 #include <sstream>
 #include <unistd.h>
 #include <fcntl.h>
@@ -29,6 +30,56 @@
 
 #if defined(__linux__)
 # include <linux/serial.h>
+# include <sys/epoll.h>
+# include <sys/eventfd.h>
+# include <sys/timerfd.h>
+# include <climits>
+# include <map>
+# if defined(__cpp_impl_coroutine)
+#  include <deque>
+# endif
+#endif
+
+#if defined(__linux__) && !defined(__powerpc__) && !defined(__mips__) \
+    && !defined(__sparc__) && !defined(__alpha__)
+// termios2, for rates outside the termios table. Declared here, the
+// kernel headers clash with <termios.h>; layout and ioctl numbers are
+// the asm-generic ones.
+# define SERIAL_TERMIOS2
+struct serial_termios2 {
+  tcflag_t c_iflag;
+  tcflag_t c_oflag;
+  tcflag_t c_cflag;
+  tcflag_t c_lflag;
+  cc_t c_line;
+  cc_t c_cc[19];
+  speed_t c_ispeed;
+  speed_t c_ospeed;
+};
+# define SERIAL_TCGETS2 _IOR ('T', 0x2A, struct serial_termios2)
+# define SERIAL_TCSETS2 _IOW ('T', 0x2B, struct serial_termios2)
+# ifndef BOTHER
+#  define BOTHER 0010000
+# endif
+# ifndef IBSHIFT
+#  define IBSHIFT 16
+# endif
+#endif
+
+#if defined(__linux__)
+# include <pty.h>
+#elif defined(__APPLE__) || defined(__OpenBSD__) || defined(__NetBSD__)
+# include <util.h>
+#else
+# include <libutil.h>
+#endif
+
+#if defined(__linux__) && defined(USE_IO_URING)
+# include <linux/io_uring.h>
+# include <sys/mman.h>
+# include <sys/syscall.h>
+# include <poll.h>
+# include <vector>
 #endif
 
 #include <sys/select.h>
@@ -40,7 +91,7 @@
 #include <mach/mach.h>
 #endif
 
-#include "serial/impl/unix.h"
+#include "xSerialImpl-unix.h"
 
 #ifndef TIOCINQ
 #ifdef FIONREAD
@@ -57,37 +108,38 @@
 using std::string;
 using std::stringstream;
 using std::invalid_argument;
-using serial::MillisecondTimer;
+using serial::Deadline;
 using serial::Serial;
 using serial::SerialException;
 using serial::PortNotOpenedException;
 using serial::IOException;
+using serial::Statistics;
+
 
+static const int64_t NS_PER_MS = 1000000;
+static const int64_t NS_PER_SEC = 1000000000;
 
-MillisecondTimer::MillisecondTimer (const uint32_t millis)
-  : expiry(timespec_now())
+Deadline::Deadline (int64_t timeout_ns)
+  : expiry_ (now () + timeout_ns)
 {
-  int64_t tv_nsec = expiry.tv_nsec + (millis * 1e6);
-  if (tv_nsec >= 1e9) {
-    int64_t sec_diff = tv_nsec / static_cast<int> (1e9);
-    expiry.tv_nsec = tv_nsec % static_cast<int>(1e9);
-    expiry.tv_sec += sec_diff;
-  } else {
-    expiry.tv_nsec = tv_nsec;
-  }
 }
 
-int64_t
-MillisecondTimer::remaining ()
+Deadline
+Deadline::fromMillis (int64_t millis)
 {
-  timespec now(timespec_now());
-  int64_t millis = (expiry.tv_sec - now.tv_sec) * 1e3;
-  millis += (expiry.tv_nsec - now.tv_nsec) / 1e6;
-  return millis;
+  return Deadline (millis * NS_PER_MS);
 }
 
-timespec
-MillisecondTimer::timespec_now ()
+Deadline
+Deadline::at (int64_t expiry_ns)
+{
+  Deadline deadline (0);
+  deadline.expiry_ = expiry_ns;
+  return deadline;
+}
+
+int64_t
+Deadline::now ()
 {
   timespec time;
 # ifdef __MACH__ // OS X does not have clock_gettime, use clock_get_time
@@ -101,25 +153,506 @@ MillisecondTimer::timespec_now ()
 # else
   clock_gettime(CLOCK_MONOTONIC, &time);
 # endif
-  return time;
+  return static_cast<int64_t> (time.tv_sec) * NS_PER_SEC + time.tv_nsec;
+}
+
+int64_t
+Deadline::remaining () const
+{
+  return expiry_ - now ();
+}
+
+int64_t
+Deadline::remainingMillis () const
+{
+  return remaining () / NS_PER_MS;
 }
 
 timespec
-timespec_from_ms (const uint32_t millis)
+Deadline::remainingTimespec () const
+{
+  return timespec_from_ns (std::max<int64_t> (remaining (), 0));
+}
+
+#if defined(__linux__)
+void
+Deadline::arm (int timerfd) const
+{
+  itimerspec spec;
+  memset (&spec, 0, sizeof (spec));
+  // A zero it_value disarms, an expired deadline must still fire.
+  spec.it_value = timespec_from_ns (std::max<int64_t> (expiry_, 1));
+  if (-1 == timerfd_settime (timerfd, TFD_TIMER_ABSTIME, &spec, NULL)) {
+    THROW (IOException, errno);
+  }
+}
+#endif
+
+timespec
+serial::timespec_from_ns (int64_t ns)
 {
   timespec time;
-  time.tv_sec = millis / 1e3;
-  time.tv_nsec = (millis - (time.tv_sec * 1e3)) * 1e6;
+  time.tv_sec = static_cast<time_t> (ns / NS_PER_SEC);
+  time.tv_nsec = static_cast<long> (ns % NS_PER_SEC);
   return time;
 }
 
+timespec
+timespec_from_ms (const uint32_t millis)
+{
+  return serial::timespec_from_ns (static_cast<int64_t> (millis) * NS_PER_MS);
+}
+
+#if defined(__linux__) && defined(USE_IO_URING)
+
+/*
+ * io_uring ring serving one port, driven through the raw syscalls.
+ *
+ * One read is kept posted on the port at all times. Its completion is
+ * moved into a staging buffer and the read is posted again right away, so
+ * the driver keeps being drained while the caller parses. Every pass over
+ * the completion queue takes all the completions queued, and writes share
+ * the same ring. The ring state is guarded by its own mutex because the
+ * read and the write side of a port may run on different threads.
+ */
+class serial::IoUring {
+public:
+  explicit IoUring (int fd);
+  ~IoUring ();
+
+  // Collect every queued completion and repost the read, never waits.
+  void reap ();
+
+  // Wait up to timeout_ns for a completion, then reap. Returns true when
+  // bytes are staged or the read failed.
+  bool wait (int64_t timeout_ns);
+
+  // Number of bytes staged, after reaping.
+  size_t staged ();
+
+  // Move up to size staged bytes into buf, throws once the staged bytes
+  // are exhausted and the read failed.
+  size_t take (uint8_t *buf, size_t size);
+
+  // Drop the staged bytes.
+  void clear ();
+
+  // Write from data within the timer, returns the bytes written, zero
+  // on timeout.
+  size_t write (const uint8_t *data, size_t length, const Deadline &deadline);
+
+private:
+  enum { READ_TAG = 1, WRITE_TAG = 2, CANCEL_TAG = 3 };
+  enum { READ_SIZE = 4096 };
+
+  void queue (uint8_t opcode, uint64_t tag, const void *buf, size_t len);
+  void cancel (uint64_t tag);
+  void submit ();
+  void reapLocked ();
+  int enter (unsigned to_submit, unsigned min_complete, unsigned flags,
+             const void *arg, size_t argsz);
+
+  class ScopedLock {
+  public:
+    explicit ScopedLock (pthread_mutex_t &mutex) : mutex_ (mutex)
+    {
+      pthread_mutex_lock (&mutex_);
+    }
+    ~ScopedLock ()
+    {
+      pthread_mutex_unlock (&mutex_);
+    }
+  private:
+    ScopedLock (const ScopedLock &);
+    ScopedLock &operator= (const ScopedLock &);
+    pthread_mutex_t &mutex_;
+  };
+
+  int fd_;                    // The port file descriptor
+  int ring_fd_;               // The io_uring instance
+  bool ext_arg_;              // Kernel takes a timeout on io_uring_enter
+
+  void *sq_ptr_;
+  size_t sq_size_;
+  void *cq_ptr_;
+  size_t cq_size_;
+  io_uring_sqe *sqes_;
+  size_t sqes_size_;
+  unsigned *sq_tail_;
+  unsigned *sq_mask_;
+  unsigned *sq_array_;
+  unsigned *cq_head_;
+  unsigned *cq_tail_;
+  unsigned *cq_mask_;
+  io_uring_cqe *cqes_;
+  unsigned to_submit_;        // Queued, not yet submitted entries
+
+  uint8_t read_buf_[READ_SIZE];
+  bool read_posted_;
+  int read_error_;            // errno of the failed read, -1 on end of file
+  std::vector<uint8_t> staged_;
+  size_t staged_head_;
+
+  bool write_posted_;
+  int write_res_;
+
+  pthread_mutex_t mutex_;
+};
+
+using serial::IoUring;
+
+IoUring::IoUring (int fd)
+  : fd_ (fd), ring_fd_ (-1), ext_arg_ (false),
+    sq_ptr_ (MAP_FAILED), sq_size_ (0), cq_ptr_ (MAP_FAILED), cq_size_ (0),
+    sqes_ (static_cast<io_uring_sqe *> (MAP_FAILED)), sqes_size_ (0),
+    to_submit_ (0), read_posted_ (false), read_error_ (0), staged_head_ (0),
+    write_posted_ (false), write_res_ (0)
+{
+  io_uring_params params;
+  memset (&params, 0, sizeof (params));
+  ring_fd_ = static_cast<int> (syscall (__NR_io_uring_setup, 4, &params));
+  if (ring_fd_ == -1) {
+    THROW (IOException, errno);
+  }
+  ext_arg_ = (params.features & IORING_FEAT_EXT_ARG) != 0;
+
+  sq_size_ = params.sq_off.array + params.sq_entries * sizeof (unsigned);
+  cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof (io_uring_cqe);
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    sq_size_ = cq_size_ = std::max (sq_size_, cq_size_);
+  }
+  sq_ptr_ = mmap (NULL, sq_size_, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+  if (sq_ptr_ != MAP_FAILED && (params.features & IORING_FEAT_SINGLE_MMAP)) {
+    cq_ptr_ = sq_ptr_;
+  } else if (sq_ptr_ != MAP_FAILED) {
+    cq_ptr_ = mmap (NULL, cq_size_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+  }
+  sqes_size_ = params.sq_entries * sizeof (io_uring_sqe);
+  if (cq_ptr_ != MAP_FAILED) {
+    sqes_ = static_cast<io_uring_sqe *> (
+      mmap (NULL, sqes_size_, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES));
+  }
+  if (sqes_ == MAP_FAILED) {
+    int err = errno;
+    if (cq_ptr_ != MAP_FAILED && cq_ptr_ != sq_ptr_)
+      munmap (cq_ptr_, cq_size_);
+    if (sq_ptr_ != MAP_FAILED)
+      munmap (sq_ptr_, sq_size_);
+    ::close (ring_fd_);
+    THROW (IOException, err);
+  }
+
+  uint8_t *sq = static_cast<uint8_t *> (sq_ptr_);
+  uint8_t *cq = static_cast<uint8_t *> (cq_ptr_);
+  sq_tail_ = reinterpret_cast<unsigned *> (sq + params.sq_off.tail);
+  sq_mask_ = reinterpret_cast<unsigned *> (sq + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<unsigned *> (sq + params.sq_off.array);
+  cq_head_ = reinterpret_cast<unsigned *> (cq + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned *> (cq + params.cq_off.tail);
+  cq_mask_ = reinterpret_cast<unsigned *> (cq + params.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<io_uring_cqe *> (cq + params.cq_off.cqes);
+
+  pthread_mutex_init (&mutex_, NULL);
+
+  queue (IORING_OP_READ, READ_TAG, read_buf_, READ_SIZE);
+  read_posted_ = true;
+  submit ();
+}
+
+IoUring::~IoUring ()
+{
+  // The kernel may still write into read_buf_, wait for the posted read
+  // to be cancelled before the buffer goes away.
+  try {
+    if (read_posted_) {
+      cancel (READ_TAG);
+      submit ();
+    }
+    for (int i = 0; read_posted_ && i < 100; ++i) {
+      pollfd pfd = { ring_fd_, POLLIN, 0 };
+      ::poll (&pfd, 1, 10);
+      ScopedLock lock (mutex_);
+      reapLocked ();
+    }
+  } catch (...) {
+    // Nothing left to do but release the ring.
+  }
+  pthread_mutex_destroy (&mutex_);
+
+  munmap (sqes_, sqes_size_);
+  if (cq_ptr_ != sq_ptr_)
+    munmap (cq_ptr_, cq_size_);
+  munmap (sq_ptr_, sq_size_);
+  ::close (ring_fd_);
+}
+
+int
+IoUring::enter (unsigned to_submit, unsigned min_complete, unsigned flags,
+                const void *arg, size_t argsz)
+{
+  return static_cast<int> (syscall (__NR_io_uring_enter, ring_fd_, to_submit,
+                                    min_complete, flags, arg, argsz));
+}
+
+void
+IoUring::queue (uint8_t opcode, uint64_t tag, const void *buf, size_t len)
+{
+  unsigned tail = *sq_tail_;
+  unsigned index = tail & *sq_mask_;
+  io_uring_sqe *sqe = &sqes_[index];
+  memset (sqe, 0, sizeof (*sqe));
+  sqe->opcode = opcode;
+  sqe->fd = fd_;
+  sqe->addr = reinterpret_cast<uint64_t> (buf);
+  sqe->len = static_cast<uint32_t> (len);
+  sqe->off = static_cast<uint64_t> (-1); // Current position, as read(2)
+  sqe->user_data = tag;
+  // A tty write may block inline in io_uring_enter once the line is
+  // full, where no deadline can cancel it. Hand writes to a worker.
+  if (opcode == IORING_OP_WRITE) {
+    sqe->flags = IOSQE_ASYNC;
+  }
+  sq_array_[index] = index;
+  __atomic_store_n (sq_tail_, tail + 1, __ATOMIC_RELEASE);
+  ++to_submit_;
+}
+
+void
+IoUring::cancel (uint64_t tag)
+{
+  unsigned tail = *sq_tail_;
+  unsigned index = tail & *sq_mask_;
+  io_uring_sqe *sqe = &sqes_[index];
+  memset (sqe, 0, sizeof (*sqe));
+  sqe->opcode = IORING_OP_ASYNC_CANCEL;
+  sqe->fd = -1;
+  sqe->addr = tag;
+  sqe->user_data = CANCEL_TAG;
+  sq_array_[index] = index;
+  __atomic_store_n (sq_tail_, tail + 1, __ATOMIC_RELEASE);
+  ++to_submit_;
+}
+
+void
+IoUring::submit ()
+{
+  while (to_submit_ > 0) {
+    int r = enter (to_submit_, 0, 0, NULL, 0);
+    if (r < 0) {
+      if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+        continue;
+      }
+      THROW (IOException, errno);
+    }
+    to_submit_ -= static_cast<unsigned> (r);
+  }
+}
+
+void
+IoUring::reapLocked ()
+{
+  unsigned head = *cq_head_;
+  unsigned tail = __atomic_load_n (cq_tail_, __ATOMIC_ACQUIRE);
+  bool repost = false;
+  for (; head != tail; ++head) {
+    const io_uring_cqe &cqe = cqes_[head & *cq_mask_];
+    if (cqe.user_data == READ_TAG) {
+      read_posted_ = false;
+      if (cqe.res > 0) {
+        if (staged_head_ == staged_.size ()) {
+          staged_.clear ();
+          staged_head_ = 0;
+        }
+        staged_.insert (staged_.end (), read_buf_, read_buf_ + cqe.res);
+        repost = true;
+      } else if (cqe.res == -EINTR || cqe.res == -EAGAIN) {
+        repost = true;
+      } else if (cqe.res == 0) {
+        // Disconnected devices report end of file.
+        read_error_ = -1;
+      } else if (cqe.res != -ECANCELED) {
+        read_error_ = -cqe.res;
+      }
+    } else if (cqe.user_data == WRITE_TAG) {
+      write_posted_ = false;
+      write_res_ = cqe.res;
+    }
+  }
+  __atomic_store_n (cq_head_, head, __ATOMIC_RELEASE);
+  if (repost) {
+    queue (IORING_OP_READ, READ_TAG, read_buf_, READ_SIZE);
+    read_posted_ = true;
+    submit ();
+  }
+}
+
+void
+IoUring::reap ()
+{
+  ScopedLock lock (mutex_);
+  reapLocked ();
+}
+
+bool
+IoUring::wait (int64_t timeout_ns)
+{
+  if (timeout_ns < 0) {
+    timeout_ns = 0;
+  }
+  int r;
+  if (ext_arg_) {
+    __kernel_timespec ts;
+    ts.tv_sec = timeout_ns / NS_PER_SEC;
+    ts.tv_nsec = timeout_ns % NS_PER_SEC;
+    io_uring_getevents_arg arg;
+    memset (&arg, 0, sizeof (arg));
+    arg.ts = reinterpret_cast<uint64_t> (&ts);
+    r = enter (0, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+               &arg, sizeof (arg));
+  } else {
+    // poll only has milliseconds, round up so it never wakes early
+    pollfd pfd = { ring_fd_, POLLIN, 0 };
+    r = ::poll (&pfd, 1, static_cast<int> (
+      std::min<int64_t> ((timeout_ns + NS_PER_MS - 1) / NS_PER_MS, INT_MAX)));
+  }
+  if (r < 0 && errno != ETIME && errno != EINTR) {
+    THROW (IOException, errno);
+  }
+  ScopedLock lock (mutex_);
+  reapLocked ();
+  return staged_head_ < staged_.size () || read_error_ != 0;
+}
+
+size_t
+IoUring::staged ()
+{
+  ScopedLock lock (mutex_);
+  return staged_.size () - staged_head_;
+}
+
+size_t
+IoUring::take (uint8_t *buf, size_t size)
+{
+  ScopedLock lock (mutex_);
+  size_t count = std::min (size, staged_.size () - staged_head_);
+  if (count > 0) {
+    memcpy (buf, &staged_[staged_head_], count);
+    staged_head_ += count;
+  }
+  int err = read_error_;
+  if (count == 0 && err == -1) {
+    throw SerialException ("device reports readiness to read but "
+                           "returned no data (device disconnected?)");
+  }
+  if (count == 0 && err != 0) {
+    THROW (IOException, err);
+  }
+  return count;
+}
+
+void
+IoUring::clear ()
+{
+  ScopedLock lock (mutex_);
+  staged_.clear ();
+  staged_head_ = 0;
+}
+
+size_t
+IoUring::write (const uint8_t *data, size_t length, const Deadline &deadline)
+{
+  {
+    ScopedLock lock (mutex_);
+    queue (IORING_OP_WRITE, WRITE_TAG, data, length);
+    write_posted_ = true;
+    submit ();
+    reapLocked ();
+  }
+  bool cancelled = false;
+  int res = 0;
+  while (true) {
+    {
+      ScopedLock lock (mutex_);
+      if (!write_posted_) {
+        res = write_res_;
+        break;
+      }
+      if (deadline.remaining () <= 0 && !cancelled) {
+        // Timed out, data belongs to the caller so the write has to be
+        // cancelled and completed before returning.
+        cancel (WRITE_TAG);
+        submit ();
+        cancelled = true;
+      }
+    }
+    wait (cancelled ? 10 * NS_PER_MS : deadline.remaining ());
+  }
+  if (res == -ECANCELED || res == -EINTR || res == -EAGAIN) {
+    return 0;
+  }
+  if (res == 0) {
+    // Disconnected devices, at least on Linux, show the behavior that
+    // they are always ready to write immediately but writing returns
+    // nothing.
+    throw SerialException ("device reports readiness to write but "
+                           "returned no data (device disconnected?)");
+  }
+  if (res < 0) {
+    THROW (IOException, -res);
+  }
+  return static_cast<size_t> (res);
+}
+
+#else
+
+// io_uring transport not built in, see transport_io_uring
+class serial::IoUring {};
+
+#endif // defined(__linux__) && defined(USE_IO_URING)
+
+// O_NONBLOCK set on fd while in scope, when enable, the flags restored
+// after. Streaming reads keep the fd blocking, its writes must not be.
+class NonBlockingScope {
+public:
+  NonBlockingScope (int fd, bool enable) : fd_ (enable ? fd : -1), flags_ (0)
+  {
+    if (fd_ == -1) {
+      return;
+    }
+    flags_ = fcntl (fd_, F_GETFL, 0);
+    if (flags_ == -1 || -1 == fcntl (fd_, F_SETFL, flags_ | O_NONBLOCK)) {
+      THROW (IOException, errno);
+    }
+  }
+
+  ~NonBlockingScope ()
+  {
+    if (fd_ != -1) {
+      fcntl (fd_, F_SETFL, flags_);
+    }
+  }
+
+private:
+  NonBlockingScope (const NonBlockingScope &);
+  NonBlockingScope &operator= (const NonBlockingScope &);
+
+  int fd_;
+  int flags_;
+};
+
 Serial::SerialImpl::SerialImpl (const string &port, unsigned long baudrate,
                                 bytesize_t bytesize,
                                 parity_t parity, stopbits_t stopbits,
                                 flowcontrol_t flowcontrol)
   : port_ (port), fd_ (-1), is_open_ (false), xonxoff_ (false), rtscts_ (false),
     baudrate_ (baudrate), parity_ (parity),
-    bytesize_ (bytesize), stopbits_ (stopbits), flowcontrol_ (flowcontrol)
+    bytesize_ (bytesize), stopbits_ (stopbits), flowcontrol_ (flowcontrol),
+    transport_ (transport_default), uring_ (NULL),
+    low_latency_ (false), low_latency_applied_ (false),
+    latency_timer_ (0), latency_saved_ (-1)
 {
   pthread_mutex_init(&this->read_mutex, NULL);
   pthread_mutex_init(&this->write_mutex, NULL);
@@ -134,6 +667,87 @@ Serial::SerialImpl::~SerialImpl ()
   pthread_mutex_destroy(&this->write_mutex);
 }
 
+// sysfs latency_timer of the USB-serial adapter behind port, empty when
+// it has none. Symlinks such as /dev/serial/by-id/... are followed to the
+// tty name first.
+static string
+latency_timer_path (const string &port)
+{
+#if defined(__linux__)
+  char *real = ::realpath (port.c_str (), NULL);
+  if (real == NULL) {
+    return "";
+  }
+  string name (real);
+  free (real);
+  name = name.substr (name.rfind ('/') + 1);
+
+  string path ("/sys/class/tty/" + name + "/device/latency_timer");
+  if (::access (path.c_str (), R_OK) == 0) {
+    return path;
+  }
+#else
+  (void) port;
+#endif
+  return "";
+}
+
+// Value of a sysfs latency_timer, -1 on error.
+static int
+read_latency_timer (const string &path)
+{
+  int fd = ::open (path.c_str (), O_RDONLY);
+  if (fd == -1) {
+    return -1;
+  }
+  char text[16];
+  ssize_t got = ::read (fd, text, sizeof (text) - 1);
+  ::close (fd);
+  if (got <= 0) {
+    return -1;
+  }
+  text[got] = '\0';
+  return atoi (text);
+}
+
+// Write a sysfs latency_timer, false when refused.
+static bool
+write_latency_timer (const string &path, int millis)
+{
+  int fd = ::open (path.c_str (), O_WRONLY);
+  if (fd == -1) {
+    return false;
+  }
+  char text[16];
+  int length = snprintf (text, sizeof (text), "%d\n", millis);
+  bool done = ::write (fd, text, length) == length;
+  ::close (fd);
+  return done;
+}
+
+// Kernel UART error counters into counts, false where the driver keeps
+// none. They run from the first open of the tty, see icount_base_.
+static bool
+read_icount (int fd, Statistics &counts)
+{
+#if defined(__linux__) && defined(TIOCGICOUNT)
+  struct serial_icounter_struct icount;
+  if (-1 == ioctl (fd, TIOCGICOUNT, &icount)) {
+    return false;
+  }
+  counts.overrun = static_cast<uint64_t> (icount.overrun);
+  counts.frame = static_cast<uint64_t> (icount.frame);
+  counts.parity = static_cast<uint64_t> (icount.parity);
+  counts.brk = static_cast<uint64_t> (icount.brk);
+  counts.buf_overrun = static_cast<uint64_t> (icount.buf_overrun);
+  return true;
+#else
+  (void) fd;
+  (void) counts;
+  return false;
+#endif
+}
+
 void
 Serial::SerialImpl::open ()
 {
@@ -160,8 +774,53 @@ Serial::SerialImpl::open ()
     }
   }
 
+  if (transport_ == transport_io_uring) {
+#if defined(__linux__) && defined(USE_IO_URING)
+    // The posted read has to block in the kernel until data arrives.
+    int flags = fcntl (fd_, F_GETFL);
+    if (flags == -1 || -1 == fcntl (fd_, F_SETFL, flags & ~O_NONBLOCK)) {
+      int err = errno;
+      ::close (fd_);
+      fd_ = -1;
+      THROW (IOException, err);
+    }
+    try {
+      reconfigurePort ();
+      uring_ = new IoUring (fd_);
+    } catch (...) {
+      ::close (fd_);
+      fd_ = -1;
+      throw;
+    }
+    is_open_ = true;
+    applyLatencyTimer ();
+    icount_base_ = Statistics ();
+    read_icount (fd_, icount_base_);
+    return;
+#else
+    ::close (fd_);
+    fd_ = -1;
+    throw invalid_argument ("io_uring transport is not built in, "
+                            "define USE_IO_URING.");
+#endif
+  }
+
+  if (transport_ == transport_streaming) {
+    // VMIN and VTIME only hold a blocking read in the kernel.
+    int flags = fcntl (fd_, F_GETFL);
+    if (flags == -1 || -1 == fcntl (fd_, F_SETFL, flags & ~O_NONBLOCK)) {
+      int err = errno;
+      ::close (fd_);
+      fd_ = -1;
+      THROW (IOException, err);
+    }
+  }
+
   reconfigurePort();
   is_open_ = true;
+  applyLatencyTimer ();
+  icount_base_ = Statistics ();
+  read_icount (fd_, icount_base_);
 }
 
 void
@@ -319,8 +978,10 @@ Serial::SerialImpl::reconfigurePort ()
     if (-1 == ioctl (fd_, IOSSIOSPEED, &new_baud, 1)) {
       THROW (IOException, errno);
     }
-    // Linux Support
+#elif defined(SERIAL_TERMIOS2)
+    // Linux Support, termios2 BOTHER, set below once the other options are applied
 #elif defined(__linux__) && defined (TIOCSSERIAL)
+    // Older Linux Support
     struct serial_struct ser;
 
     if (-1 == ioctl (fd_, TIOCGSERIAL, &ser)) {
@@ -346,6 +1007,11 @@ Serial::SerialImpl::reconfigurePort ()
 #else
     ::cfsetispeed(&options, baud);
     ::cfsetospeed(&options, baud);
+#endif
+#if defined(SERIAL_TERMIOS2)
+    // Drop a BOTHER input rate left by an earlier custom baud, input
+    // then follows the output rate again.
+    options.c_cflag &= (tcflag_t) ~(CBAUD << IBSHIFT);
 #endif
   }
 
@@ -444,18 +1110,122 @@ Serial::SerialImpl::reconfigurePort ()
   // to read before each call, so we should never needlessly poll
   options.c_cc[VMIN] = 0;
   options.c_cc[VTIME] = 0;
+  // The io_uring transport keeps a read posted instead, it must block
+  // until at least one byte arrives.
+  if (transport_ == transport_io_uring) {
+    options.c_cc[VMIN] = 1;
+  }
+  // The streaming transport waits for the first byte with select and
+  // lets the kernel hold the read for the rest of the batch: VTIME is
+  // the inter-byte gap that ends it, in tenths of a second, and VMIN
+  // about as many bytes as the line carries in that time.
+  if (transport_ == transport_streaming) {
+    uint64_t gap = 1;
+    if (timeout_.inter_byte_timeout != Timeout::max ()) {
+      gap = (static_cast<uint64_t> (timeout_.inter_byte_timeout) + 99) / 100;
+      gap = std::max<uint64_t> (1, std::min<uint64_t> (gap, 255));
+    }
+    uint64_t batch = baudrate_ * gap / 100;
+    options.c_cc[VMIN] = static_cast<cc_t> (std::max<uint64_t> (
+      1, std::min<uint64_t> (batch, 255)));
+    options.c_cc[VTIME] = static_cast<cc_t> (gap);
+  }
 
   // activate settings
   ::tcsetattr (fd_, TCSANOW, &options);
 
+#if defined(SERIAL_TERMIOS2)
+  // Any rate the driver can make, the cflag speed bits give way to
+  // BOTHER and the exact rate goes in c_ispeed/c_ospeed.
+  if (custom_baud) {
+    struct serial_termios2 options2;
+    if (-1 == ioctl (fd_, SERIAL_TCGETS2, &options2)) {
+      THROW (IOException, errno);
+    }
+    options2.c_cflag &= (tcflag_t) ~(CBAUD | (CBAUD << IBSHIFT));
+    options2.c_cflag |= BOTHER | (BOTHER << IBSHIFT);
+    options2.c_ispeed = static_cast<speed_t> (baudrate_);
+    options2.c_ospeed = static_cast<speed_t> (baudrate_);
+    if (-1 == ioctl (fd_, SERIAL_TCSETS2, &options2)) {
+      THROW (IOException, errno);
+    }
+  }
+#endif
+
+  if (low_latency_ || low_latency_applied_) {
+    applyLowLatency (low_latency_);
+  }
+
   // Update byte_time_ based on the new settings.
-  uint32_t bit_time_ns = 1e9 / baudrate_;
+  // B0 hangs up the line, there is no byte time to speak of.
+  uint32_t bit_time_ns = baudrate_ ? static_cast<uint32_t> (NS_PER_SEC / baudrate_) : 0;
   byte_time_ns_ = bit_time_ns * (1 + bytesize_ + parity_ + stopbits_);
 
   // Compensate for the stopbits_one_point_five enum being equal to int 3,
   // and not 1.5.
   if (stopbits_ == stopbits_one_point_five) {
-    byte_time_ns_ += ((1.5 - stopbits_one_point_five) * bit_time_ns);
+    byte_time_ns_ -= bit_time_ns * 3 / 2;
+  }
+}
+
+void
+Serial::SerialImpl::applyLowLatency (bool low_latency)
+{
+#if defined(__linux__) && defined(TIOCSSERIAL) && defined(ASYNC_LOW_LATENCY)
+  struct serial_struct ser;
+  if (-1 == ioctl (fd_, TIOCGSERIAL, &ser)) {
+    // Drivers without serial_struct, ptys say, have nothing to tune.
+    if (errno == ENOTTY || errno == EINVAL) {
+      return;
+    }
+    THROW (IOException, errno);
+  }
+  const bool is_set = (ser.flags & ASYNC_LOW_LATENCY) != 0;
+  if (is_set != low_latency) {
+    if (low_latency) {
+      ser.flags |= ASYNC_LOW_LATENCY;
+    } else {
+      ser.flags &= ~ASYNC_LOW_LATENCY;
+    }
+    if (-1 == ioctl (fd_, TIOCSSERIAL, &ser)) {
+      THROW (IOException, errno);
+    }
+    low_latency_applied_ = low_latency;
+  }
+#else
+  (void) low_latency;
+#endif
+}
+
+void
+Serial::SerialImpl::applyLatencyTimer ()
+{
+  if (latency_path_.empty ()) {
+    if (latency_timer_ == 0) {
+      return;
+    }
+    latency_path_ = latency_timer_path (port_);
+    if (latency_path_.empty ()) {
+      return;
+    }
+  }
+
+  // Anything sysfs refuses leaves the adapter as it is, the port works
+  // the same, only slower; getAdapterLatency tells.
+  if (latency_timer_ == 0) {
+    if (latency_saved_ != -1) {
+      write_latency_timer (latency_path_, latency_saved_);
+      latency_saved_ = -1;
+    }
+    return;
+  }
+  int current = read_latency_timer (latency_path_);
+  if (current == -1 || current == static_cast<int> (latency_timer_)) {
+    return;
+  }
+  if (write_latency_timer (latency_path_, static_cast<int> (latency_timer_))
+      && latency_saved_ == -1) {
+    latency_saved_ = current;
   }
 }
 
@@ -463,6 +1233,23 @@ void
 Serial::SerialImpl::close ()
 {
   if (is_open_ == true) {
+    if (latency_saved_ != -1) {
+      write_latency_timer (latency_path_, latency_saved_);
+      latency_saved_ = -1;
+    }
+    latency_path_.clear ();
+    if (low_latency_applied_) {
+      // Hand the adapter back as it was found, best effort.
+      try {
+        applyLowLatency (false);
+      } catch (const IOException &) {
+      }
+      low_latency_applied_ = false;
+    }
+    if (uring_ != NULL) {
+      delete uring_;
+      uring_ = NULL;
+    }
     if (fd_ != -1) {
       int ret;
       ret = ::close (fd_);
@@ -488,22 +1275,41 @@ Serial::SerialImpl::available ()
   if (!is_open_) {
     return 0;
   }
+  size_t staged = 0;
+#if defined(__linux__) && defined(USE_IO_URING)
+  if (uring_ != NULL) {
+    uring_->reap ();
+    staged = uring_->staged ();
+  }
+#endif
   int count = 0;
   if (-1 == ioctl (fd_, TIOCINQ, &count)) {
       THROW (IOException, errno);
   } else {
-      return static_cast<size_t> (count);
+      return staged + static_cast<size_t> (count);
   }
 }
 
 bool
 Serial::SerialImpl::waitReadable (uint32_t timeout)
 {
+  return waitReadableNs (static_cast<int64_t> (timeout) * NS_PER_MS);
+}
+
+bool
+Serial::SerialImpl::waitReadableNs (int64_t timeout_ns)
+{
+#if defined(__linux__) && defined(USE_IO_URING)
+  if (uring_ != NULL) {
+    uring_->reap ();
+    return uring_->staged () > 0 || uring_->wait (timeout_ns);
+  }
+#endif
   // Setup a select call to block for serial data or a timeout
   fd_set readfds;
   FD_ZERO (&readfds);
   FD_SET (fd_, &readfds);
-  timespec timeout_ts (timespec_from_ms (timeout));
+  timespec timeout_ts (timespec_from_ns (std::max<int64_t> (timeout_ns, 0)));
   int r = pselect (fd_ + 1, &readfds, NULL, NULL, &timeout_ts, NULL);
 
   if (r < 0) {
@@ -530,8 +1336,11 @@ Serial::SerialImpl::waitReadable (uint32_t timeout)
 void
 Serial::SerialImpl::waitByteTimes (size_t count)
 {
-  timespec wait_time = { 0, static_cast<long>(byte_time_ns_ * count)};
-  pselect (0, NULL, NULL, NULL, &wait_time, NULL);
+  timespec wait_time =
+    timespec_from_ns (static_cast<int64_t> (byte_time_ns_) * count);
+  // Sleep the whole time, nanosleep leaves what is left on a signal.
+  while (-1 == nanosleep (&wait_time, &wait_time) && errno == EINTR) {
+  }
 }
 
 size_t
@@ -544,12 +1353,39 @@ Serial::SerialImpl::read (uint8_t *buf, size_t size)
   size_t bytes_read = 0;
 
   // Calculate total timeout in milliseconds t_c + (t_m * N)
-  long total_timeout_ms = timeout_.read_timeout_constant;
-  total_timeout_ms += timeout_.read_timeout_multiplier * static_cast<long> (size);
-  MillisecondTimer total_timeout(total_timeout_ms);
-
+  int64_t total_timeout_ms = timeout_.read_timeout_constant;
+  total_timeout_ms += timeout_.read_timeout_multiplier * static_cast<int64_t> (size);
+  const Deadline total_timeout (Deadline::fromMillis (total_timeout_ms));
+  // Cap of a single wait, none when inter_byte_timeout is max
+  const int64_t inter_byte_ns =
+    timeout_.inter_byte_timeout == Timeout::max ()
+      ? std::numeric_limits<int64_t>::max () : static_cast<int64_t> (timeout_.inter_byte_timeout) * NS_PER_MS;
+
+#if defined(__linux__) && defined(USE_IO_URING)
+  if (uring_ != NULL) {
+    // Same timeouts as below, bytes come from the posted read instead.
+    uring_->reap ();
+    bytes_read = uring_->take (buf, size);
+    while (bytes_read < size) {
+      int64_t timeout_remaining_ns = total_timeout.remaining ();
+      if (timeout_remaining_ns <= 0) {
+        // Timed out
+        break;
+      }
+      if (uring_->wait (std::min (timeout_remaining_ns, inter_byte_ns))) {
+        bytes_read += uring_->take (buf + bytes_read, size - bytes_read);
+      }
+    }
+    return bytes_read;
+  }
+#endif
+
+  // A blocking read would wait for VMIN bytes here, streaming only reads
+  // what select reported.
+  const bool streaming = transport_ == transport_streaming;
+
   // Pre-fill buffer with available bytes
-  {
+  if (!streaming) {
     ssize_t bytes_read_now = ::read (fd_, buf, size);
     if (bytes_read_now > 0) {
       bytes_read = bytes_read_now;
@@ -557,21 +1393,21 @@ Serial::SerialImpl::read (uint8_t *buf, size_t size)
   }
 
   while (bytes_read < size) {
-    int64_t timeout_remaining_ms = total_timeout.remaining();
-    if (timeout_remaining_ms <= 0) {
+    int64_t timeout_remaining_ns = total_timeout.remaining ();
+    if (timeout_remaining_ns <= 0) {
       // Timed out
       break;
     }
     // Timeout for the next select is whichever is less of the remaining
     // total read timeout and the inter-byte timeout.
-    uint32_t timeout = std::min(static_cast<uint32_t> (timeout_remaining_ms),
-                                timeout_.inter_byte_timeout);
     // Wait for the device to be readable, and then attempt to read.
-    if (waitReadable(timeout)) {
+    if (waitReadableNs (std::min (timeout_remaining_ns, inter_byte_ns))) {
       // If it's a fixed-length multi-byte read, insert a wait here so that
       // we can attempt to grab the whole thing in a single IO call. Skip
       // this wait if a non-max inter_byte_timeout is specified.
-      if (size > 1 && timeout_.inter_byte_timeout == Timeout::max()) {
+      // The streaming kernel read does this wait itself.
+      if (size > 1 && timeout_.inter_byte_timeout == Timeout::max()
+          && !streaming) {
         size_t bytes_available = available();
         if (bytes_available + bytes_read < size) {
           waitByteTimes(size - (bytes_available + bytes_read));
@@ -611,6 +1447,57 @@ Serial::SerialImpl::read (uint8_t *buf, size_t size)
   return bytes_read;
 }
 
+size_t
+Serial::SerialImpl::readBatch (uint8_t *buf, size_t size)
+{
+  if (!is_open_) {
+    throw PortNotOpenedException ("Serial::read");
+  }
+  if (transport_ != transport_streaming) {
+    return read (buf, size);
+  }
+
+  // The first byte gets the timeout of a one byte read, the batch after
+  // it ends at VMIN bytes or a VTIME gap: two syscalls per batch.
+  int64_t timeout_ms = timeout_.read_timeout_constant;
+  timeout_ms += timeout_.read_timeout_multiplier;
+  const Deadline first_byte (Deadline::fromMillis (timeout_ms));
+  while (true) {
+    int64_t timeout_remaining_ns = first_byte.remaining ();
+    if (timeout_remaining_ns <= 0) {
+      return 0;
+    }
+    if (waitReadableNs (timeout_remaining_ns)) {
+      break;
+    }
+  }
+  ssize_t bytes_read = ::read (fd_, buf, size);
+  if (bytes_read < 1) {
+    if (bytes_read == -1 && errno == EINTR) {
+      return 0;
+    }
+    throw SerialException ("device reports readiness to read but "
+                           "returned no data (device disconnected?)");
+  }
+  return static_cast<size_t> (bytes_read);
+}
+
+size_t
+Serial::SerialImpl::writeSome (const uint8_t *data, size_t length)
+{
+  if (is_open_ == false) {
+    throw PortNotOpenedException ("Serial::writeSome");
+  }
+  ssize_t bytes_written = ::write (fd_, data, length);
+  if (bytes_written < 0) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+      return 0;
+    }
+    THROW (IOException, errno);
+  }
+  return static_cast<size_t> (bytes_written);
+}
+
 size_t
 Serial::SerialImpl::write (const uint8_t *data, size_t length)
 {
@@ -621,23 +1508,40 @@ Serial::SerialImpl::write (const uint8_t *data, size_t length)
   size_t bytes_written = 0;
 
   // Calculate total timeout in milliseconds t_c + (t_m * N)
-  long total_timeout_ms = timeout_.write_timeout_constant;
-  total_timeout_ms += timeout_.write_timeout_multiplier * static_cast<long> (length);
-  MillisecondTimer total_timeout(total_timeout_ms);
+  int64_t total_timeout_ms = timeout_.write_timeout_constant;
+  total_timeout_ms += timeout_.write_timeout_multiplier * static_cast<int64_t> (length);
+  const Deadline total_timeout (Deadline::fromMillis (total_timeout_ms));
+
+#if defined(__linux__) && defined(USE_IO_URING)
+  if (uring_ != NULL) {
+    while (bytes_written < length) {
+      size_t bytes_written_now =
+        uring_->write (data + bytes_written, length - bytes_written,
+                       total_timeout);
+      if (bytes_written_now == 0) {
+        // Timed out
+        break;
+      }
+      bytes_written += bytes_written_now;
+    }
+    return bytes_written;
+  }
+#endif
+
+  // A blocking write would queue the whole remainder past the timeout.
+  NonBlockingScope non_blocking (fd_, transport_ == transport_streaming);
 
   bool first_iteration = true;
   while (bytes_written < length) {
-    int64_t timeout_remaining_ms = total_timeout.remaining();
     // Only consider the timeout if it's not the first iteration of the loop
     // otherwise a timeout of 0 won't be allowed through
-    if (!first_iteration && (timeout_remaining_ms <= 0)) {
+    timespec timeout (total_timeout.remainingTimespec ());
+    if (!first_iteration && timeout.tv_sec == 0 && timeout.tv_nsec == 0) {
       // Timed out
       break;
     }
     first_iteration = false;
 
-    timespec timeout(timespec_from_ms(timeout_remaining_ms));
-
     FD_ZERO (&writefds);
     FD_SET (fd_, &writefds);
 
@@ -665,6 +1569,11 @@ Serial::SerialImpl::write (const uint8_t *data, size_t length)
         // This will write some
         ssize_t bytes_written_now =
           ::write (fd_, data + bytes_written, length - bytes_written);
+        // The room select reported can be taken by another writer of the
+        // same tty, then wait again.
+        if (bytes_written_now == -1 && (errno == EAGAIN || errno == EINTR)) {
+          continue;
+        }
         // write should always return some data as select reported it was
         // ready to write when we get to this point.
         if (bytes_written_now < 1) {
@@ -712,9 +1621,12 @@ Serial::SerialImpl::getPort () const
 }
 
 void
-Serial::SerialImpl::setTimeout (serial::Timeout &timeout)
+Serial::SerialImpl::setTimeout (const serial::Timeout &timeout)
 {
   timeout_ = timeout;
+  // VTIME follows the inter-byte timeout
+  if (is_open_ && transport_ == transport_streaming)
+    reconfigurePort ();
 }
 
 serial::Timeout
@@ -793,6 +1705,61 @@ Serial::SerialImpl::getFlowcontrol () const
   return flowcontrol_;
 }
 
+void
+Serial::SerialImpl::setTransport (serial::transport_t transport)
+{
+  transport_ = transport;
+}
+
+void
+Serial::SerialImpl::setLowLatency (bool low_latency)
+{
+  low_latency_ = low_latency;
+  if (is_open_)
+    reconfigurePort ();
+}
+
+bool
+Serial::SerialImpl::getLowLatency () const
+{
+  return low_latency_;
+}
+
+void
+Serial::SerialImpl::setLatencyTimer (uint32_t millis)
+{
+  if (millis > 255) {
+    throw invalid_argument ("The latency timer is 0 to 255 ms.");
+  }
+  latency_timer_ = millis;
+  if (is_open_)
+    applyLatencyTimer ();
+}
+
+uint32_t
+Serial::SerialImpl::getLatencyTimer () const
+{
+  return latency_timer_;
+}
+
+uint32_t
+Serial::SerialImpl::getAdapterLatency () const
+{
+  if (!is_open_) {
+    return 0;
+  }
+  string path (latency_path_.empty () ? latency_timer_path (port_)
+                                      : latency_path_);
+  int current = path.empty () ? -1 : read_latency_timer (path);
+  return current == -1 ? 0 : static_cast<uint32_t> (current);
+}
+
+serial::transport_t
+Serial::SerialImpl::getTransport () const
+{
+  return transport_;
+}
+
 void
 Serial::SerialImpl::flush ()
 {
@@ -809,6 +1776,12 @@ Serial::SerialImpl::flushInput ()
     throw PortNotOpenedException ("Serial::flushInput");
   }
   tcflush (fd_, TCIFLUSH);
+#if defined(__linux__) && defined(USE_IO_URING)
+  if (uring_ != NULL) {
+    uring_->reap ();
+    uring_->clear ();
+  }
+#endif
 }
 
 void
@@ -820,6 +1793,44 @@ Serial::SerialImpl::flushOutput ()
   tcflush (fd_, TCOFLUSH);
 }
 
+void
+Serial::SerialImpl::synchronize (ostream &out)
+{
+  if (is_open_ == false) {
+    throw PortNotOpenedException ("Serial::synchronize");
+  }
+  // Drop whatever is stale on the line, then wait for the first fresh
+  // byte. Unlike Windows there is no need to reopen the port for it.
+  purge ();
+  const uint32_t wait_ms = 250;
+  bool waiting = false;
+  while (!waitReadable (wait_ms)) {
+    if (!waiting) {
+      out << "Serial unavailable, please wait, waiting for data ";
+      waiting = true;
+    }
+    out << '.' << std::flush;
+  }
+  if (waiting) {
+    out << std::endl;
+  }
+}
+
+void
+Serial::SerialImpl::purge ()
+{
+  if (is_open_ == false) {
+    throw PortNotOpenedException ("Serial::purge");
+  }
+  tcflush (fd_, TCIOFLUSH);
+#if defined(__linux__) && defined(USE_IO_URING)
+  if (uring_ != NULL) {
+    uring_->reap ();
+    uring_->clear ();
+  }
+#endif
+}
+
 void
 Serial::SerialImpl::sendBreak (int duration)
 {
@@ -1032,6 +2043,24 @@ Serial::SerialImpl::getCD ()
   }
 }
 
+void
+Serial::SerialImpl::getErrorCounters (Statistics &stats)
+{
+  if (is_open_ == false) {
+    return;
+  }
+  Statistics now;
+  if (!read_icount (fd_, now)) {
+    return;
+  }
+  Statistics since = now - icount_base_;
+  stats.overrun = since.overrun;
+  stats.frame = since.frame;
+  stats.parity = since.parity;
+  stats.brk = since.brk;
+  stats.buf_overrun = since.buf_overrun;
+}
+
 void
 Serial::SerialImpl::readLock ()
 {
@@ -1068,4 +2097,758 @@ Serial::SerialImpl::writeUnlock ()
   }
 }
 
+int
+Serial::SerialImpl::getFd () const
+{
+  return fd_;
+}
+
+#if defined(__linux__)
+
+using serial::Reactor;
+
+class serial::Reactor::ReactorImpl {
+public:
+  struct Port {
+    Serial *serial;
+    Reactor::Handler *handler;
+    string eol;
+    size_t size;
+  };
+
+  ReactorImpl () : epfd_ (-1), wakefd_ (-1), stopped_ (false) {}
+
+  int epfd_;                  // The epoll set watching every port
+  int wakefd_;                // eventfd written by stop ()
+  bool stopped_;              // Set once the wakefd_ fires
+
+  std::map<int, Port> ports_; // Registered ports, by file descriptor
+  std::vector<epoll_event> events_;
+};
+
+Reactor::Reactor ()
+  : _pimpl (new ReactorImpl)
+{
+  _pimpl->epfd_ = epoll_create1 (EPOLL_CLOEXEC);
+  if (_pimpl->epfd_ == -1) {
+    int err = errno;
+    delete _pimpl;
+    THROW (IOException, err);
+  }
+  _pimpl->wakefd_ = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC);
+  epoll_event ev;
+  memset (&ev, 0, sizeof (ev));
+  ev.events = EPOLLIN;
+  ev.data.fd = _pimpl->wakefd_;
+  if (_pimpl->wakefd_ == -1
+      || -1 == epoll_ctl (_pimpl->epfd_, EPOLL_CTL_ADD, _pimpl->wakefd_, &ev)) {
+    int err = errno;
+    if (_pimpl->wakefd_ != -1)
+      ::close (_pimpl->wakefd_);
+    ::close (_pimpl->epfd_);
+    delete _pimpl;
+    THROW (IOException, err);
+  }
+}
+
+Reactor::~Reactor ()
+{
+  ::close (_pimpl->wakefd_);
+  ::close (_pimpl->epfd_);
+  delete _pimpl;
+}
+
+void
+Reactor::add (Serial &port, Handler &handler, const string &eol,
+              const size_t size)
+{
+  if (!port.isOpen ()) {
+    throw PortNotOpenedException ("Reactor::add");
+  }
+  const int fd = port._fd ();
+  epoll_event ev;
+  memset (&ev, 0, sizeof (ev));
+  ev.events = EPOLLIN;
+  ev.data.fd = fd;
+  if (-1 == epoll_ctl (_pimpl->epfd_, EPOLL_CTL_ADD, fd, &ev)) {
+    // Registering the same port again only replaces its handler.
+    if (errno != EEXIST) {
+      THROW (IOException, errno);
+    }
+  }
+  ReactorImpl::Port entry;
+  entry.serial = &port;
+  entry.handler = &handler;
+  entry.eol = eol;
+  entry.size = size;
+  _pimpl->ports_[fd] = entry;
+}
+
+void
+Reactor::remove (Serial &port)
+{
+  std::map<int, ReactorImpl::Port>::iterator it = _pimpl->ports_.begin ();
+  for (; it != _pimpl->ports_.end (); ++it) {
+    if (it->second.serial == &port) {
+      // Fails harmlessly when the port was closed already, closing the
+      // descriptor drops it from the epoll set.
+      epoll_ctl (_pimpl->epfd_, EPOLL_CTL_DEL, it->first, NULL);
+      _pimpl->ports_.erase (it);
+      return;
+    }
+  }
+}
+
+const size_t
+Reactor::size () const
+{
+  return _pimpl->ports_.size ();
+}
+
+const size_t
+Reactor::poll (const uint32_t timeout)
+{
+  int timeout_ms = -1;
+  if (timeout != Timeout::max ()) {
+    timeout_ms = static_cast<int> (std::min<uint32_t> (timeout, INT_MAX));
+  }
+  _pimpl->events_.resize (_pimpl->ports_.size () + 1);
+  int r = epoll_wait (_pimpl->epfd_, &_pimpl->events_[0],
+                      static_cast<int> (_pimpl->events_.size ()), timeout_ms);
+  if (r < 0) {
+    // Interrupted, nothing to dispatch
+    if (errno == EINTR) {
+      return 0;
+    }
+    THROW (IOException, errno);
+  }
+
+  size_t lines = 0;
+  string line;
+  for (int i = 0; i < r; ++i) {
+    const int fd = _pimpl->events_[i].data.fd;
+    if (fd == _pimpl->wakefd_) {
+      uint64_t count;
+      ssize_t ignored = ::read (_pimpl->wakefd_, &count, sizeof (count));
+      (void) ignored;
+      _pimpl->stopped_ = true;
+      continue;
+    }
+    std::map<int, ReactorImpl::Port>::iterator it = _pimpl->ports_.find (fd);
+    if (it == _pimpl->ports_.end ()) {
+      // Removed by a handler earlier in this batch
+      continue;
+    }
+    // Handlers may add or remove ports, work on a copy of the entry.
+    const ReactorImpl::Port port = it->second;
+    try {
+      port.serial->_drain ();
+    } catch (const std::exception &e) {
+      remove (*port.serial);
+      port.handler->onError (*port.serial, e);
+      continue;
+    }
+    while (port.serial->_popline (line, port.size, port.eol)) {
+      port.handler->onLine (*port.serial, line);
+      ++lines;
+      it = _pimpl->ports_.find (fd);
+      if (it == _pimpl->ports_.end () || it->second.serial != port.serial) {
+        break;
+      }
+    }
+  }
+  return lines;
+}
+
+void
+Reactor::run ()
+{
+  _pimpl->stopped_ = false;
+  while (!_pimpl->stopped_) {
+    poll (Timeout::max ());
+  }
+}
+
+void
+Reactor::stop ()
+{
+  uint64_t one = 1;
+  ssize_t ignored = ::write (_pimpl->wakefd_, &one, sizeof (one));
+  (void) ignored;
+}
+
+#endif // defined(__linux__)
+
+#if defined(XTOOLS_COROUTINES)
+
+using serial::EventLoop;
+
+class serial::EventLoop::EventLoopImpl {
+public:
+  typedef std::coroutine_handle<Task::promise_type> Handle;
+
+  struct Fd {
+    Waiter *reader;
+    Waiter *writer;
+  };
+
+  EventLoopImpl () : epfd_ (-1), timerfd_ (-1), armed_ (0), stopped_ (false) {}
+
+  // Register w with epoll and its deadline, until finish (w)
+  void park (Waiter *w);
+
+  // Drop w from epoll and the timers, resume its task on the next pass
+  void finish (Waiter *w);
+
+  // Resume every task queued, reaping the ones that returned
+  size_t resume ();
+
+  int epfd_;                          // The epoll set watching every port
+  int timerfd_;                       // Fires at the earliest deadline
+  int64_t armed_;                     // Deadline timerfd_ is armed at, or 0
+  bool stopped_;                      // Set by stop ()
+
+  std::map<void *, Handle> tasks_;    // Tasks alive, by frame address
+  std::deque<Handle> ready_;          // Tasks to resume
+  std::map<int, Fd> fds_;             // Waiters parked, by file descriptor
+  std::multimap<int64_t, Waiter *> timers_; // Waiters parked, by deadline ns
+  std::vector<epoll_event> events_;
+
+private:
+  void watch (int fd, const Fd &entry, bool added);
+};
+
+void
+EventLoop::EventLoopImpl::watch (int fd, const Fd &entry, bool added)
+{
+  epoll_event ev;
+  memset (&ev, 0, sizeof (ev));
+  ev.events = (entry.reader ? uint32_t (EPOLLIN) : 0u)
+            | (entry.writer ? uint32_t (EPOLLOUT) : 0u);
+  ev.data.fd = fd;
+  if (ev.events == 0) {
+    // Fails harmlessly when the port was closed already
+    epoll_ctl (epfd_, EPOLL_CTL_DEL, fd, NULL);
+    fds_.erase (fd);
+  } else if (-1 == epoll_ctl (epfd_, added ? EPOLL_CTL_ADD : EPOLL_CTL_MOD,
+                              fd, &ev)) {
+    THROW (IOException, errno);
+  }
+}
+
+void
+EventLoop::EventLoopImpl::park (Waiter *w)
+{
+  if (w->_fd != -1) {
+    std::map<int, Fd>::iterator it = fds_.find (w->_fd);
+    const bool added = it == fds_.end ();
+    if (added) {
+      Fd entry = { NULL, NULL };
+      it = fds_.insert (std::make_pair (w->_fd, entry)).first;
+    }
+    Waiter *&slot = w->_write ? it->second.writer : it->second.reader;
+    if (slot != NULL) {
+      throw invalid_argument ("another task already waits on this port");
+    }
+    slot = w;
+    try {
+      watch (w->_fd, it->second, added);
+    } catch (...) {
+      slot = NULL;
+      if (added) {
+        fds_.erase (it);
+      }
+      throw;
+    }
+  }
+  if (w->_timeout != Timeout::max ()) {
+    w->_deadline = Deadline::fromMillis (w->_timeout).expiry ();
+    timers_.insert (std::make_pair (w->_deadline, w));
+  }
+}
+
+void
+EventLoop::EventLoopImpl::finish (Waiter *w)
+{
+  if (w->_fd != -1) {
+    std::map<int, Fd>::iterator it = fds_.find (w->_fd);
+    if (it != fds_.end ()) {
+      (w->_write ? it->second.writer : it->second.reader) = NULL;
+      try {
+        watch (w->_fd, it->second, false);
+      } catch (const IOException &) {
+        // The port went away, nothing left to watch
+        fds_.erase (it);
+      }
+    }
+  }
+  if (w->_timeout != Timeout::max ()) {
+    std::pair<std::multimap<int64_t, Waiter *>::iterator,
+              std::multimap<int64_t, Waiter *>::iterator>
+      range = timers_.equal_range (w->_deadline);
+    for (; range.first != range.second; ++range.first) {
+      if (range.first->second == w) {
+        timers_.erase (range.first);
+        break;
+      }
+    }
+  }
+  ready_.push_back (w->_task);
+}
+
+size_t
+EventLoop::EventLoopImpl::resume ()
+{
+  std::deque<Handle> batch;
+  batch.swap (ready_);
+  size_t resumed = 0;
+  while (!batch.empty ()) {
+    Handle task = batch.front ();
+    batch.pop_front ();
+    task.resume ();
+    ++resumed;
+    if (!task.done ()) {
+      continue;
+    }
+    std::exception_ptr error = task.promise ().error;
+    tasks_.erase (task.address ());
+    task.destroy ();
+    if (error) {
+      // Keep the rest of the batch for the next poll
+      ready_.insert (ready_.begin (), batch.begin (), batch.end ());
+      std::rethrow_exception (error);
+    }
+  }
+  return resumed;
+}
+
+EventLoop::Waiter::Waiter (const int fd, const bool write,
+                           const uint32_t timeout)
+  : _fd (fd), _write (write), _timeout (timeout), _deadline (0)
+{
+}
+
+void
+EventLoop::Waiter::await_suspend (std::coroutine_handle<Task::promise_type> task)
+{
+  _task = task;
+  task.promise ().loop->_pimpl->park (this);
+}
+
+EventLoop::EventLoop ()
+  : _pimpl (new EventLoopImpl)
+{
+  _pimpl->epfd_ = epoll_create1 (EPOLL_CLOEXEC);
+  if (_pimpl->epfd_ == -1) {
+    int err = errno;
+    delete _pimpl;
+    THROW (IOException, err);
+  }
+  // Every deadline shares this timerfd, armed at the earliest one.
+  _pimpl->timerfd_ = timerfd_create (CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  epoll_event ev;
+  memset (&ev, 0, sizeof (ev));
+  ev.events = EPOLLIN;
+  ev.data.fd = _pimpl->timerfd_;
+  if (_pimpl->timerfd_ == -1
+      || -1 == epoll_ctl (_pimpl->epfd_, EPOLL_CTL_ADD, _pimpl->timerfd_, &ev)) {
+    int err = errno;
+    if (_pimpl->timerfd_ != -1)
+      ::close (_pimpl->timerfd_);
+    ::close (_pimpl->epfd_);
+    delete _pimpl;
+    THROW (IOException, err);
+  }
+}
+
+EventLoop::~EventLoop ()
+{
+  std::map<void *, EventLoopImpl::Handle>::iterator it = _pimpl->tasks_.begin ();
+  for (; it != _pimpl->tasks_.end (); ++it) {
+    it->second.destroy ();
+  }
+  ::close (_pimpl->timerfd_);
+  ::close (_pimpl->epfd_);
+  delete _pimpl;
+}
+
+void
+EventLoop::spawn (Task task)
+{
+  EventLoopImpl::Handle handle = task._handle;
+  task._handle = nullptr;
+  handle.promise ().loop = this;
+  _pimpl->tasks_[handle.address ()] = handle;
+  _pimpl->ready_.push_back (handle);
+}
+
+const size_t
+EventLoop::size () const
+{
+  return _pimpl->tasks_.size ();
+}
+
+const size_t
+EventLoop::poll (const uint32_t timeout)
+{
+  size_t resumed = _pimpl->resume ();
+
+  int timeout_ms = -1;
+  if (resumed != 0 || !_pimpl->ready_.empty ()) {
+    timeout_ms = 0;
+  } else if (timeout != Timeout::max ()) {
+    timeout_ms = static_cast<int> (std::min<uint32_t> (timeout, INT_MAX));
+  }
+  // The timerfd wakes epoll_wait at the earliest deadline, to the ns.
+  if (!_pimpl->timers_.empty ()
+      && _pimpl->timers_.begin ()->first != _pimpl->armed_) {
+    _pimpl->armed_ = _pimpl->timers_.begin ()->first;
+    Deadline::at (_pimpl->armed_).arm (_pimpl->timerfd_);
+  }
+
+  _pimpl->events_.resize (_pimpl->fds_.size () + 2);
+  int r = epoll_wait (_pimpl->epfd_, &_pimpl->events_[0],
+                      static_cast<int> (_pimpl->events_.size ()), timeout_ms);
+  if (r < 0) {
+    // Interrupted, only the timers may be due
+    if (errno != EINTR) {
+      THROW (IOException, errno);
+    }
+    r = 0;
+  }
+
+  for (int i = 0; i < r; ++i) {
+    const int fd = _pimpl->events_[i].data.fd;
+    const uint32_t events = _pimpl->events_[i].events;
+    if (fd == _pimpl->timerfd_) {
+      uint64_t expirations;
+      ssize_t ignored = ::read (_pimpl->timerfd_, &expirations,
+                                sizeof (expirations));
+      (void) ignored;
+      _pimpl->armed_ = 0;
+      continue;
+    }
+    std::map<int, EventLoopImpl::Fd>::iterator it = _pimpl->fds_.find (fd);
+    if (it != _pimpl->fds_.end () && it->second.reader
+        && (events & (EPOLLIN | EPOLLERR | EPOLLHUP))
+        && it->second.reader->ready ()) {
+      _pimpl->finish (it->second.reader);
+    }
+    it = _pimpl->fds_.find (fd);
+    if (it != _pimpl->fds_.end () && it->second.writer
+        && (events & (EPOLLOUT | EPOLLERR | EPOLLHUP))
+        && it->second.writer->ready ()) {
+      _pimpl->finish (it->second.writer);
+    }
+  }
+
+  const int64_t now = Deadline::now ();
+  while (!_pimpl->timers_.empty () && _pimpl->timers_.begin ()->first <= now) {
+    Waiter *w = _pimpl->timers_.begin ()->second;
+    w->expire ();
+    _pimpl->finish (w);
+  }
+
+  return resumed + _pimpl->resume ();
+}
+
+void
+EventLoop::run ()
+{
+  _pimpl->stopped_ = false;
+  while (!_pimpl->stopped_ && !_pimpl->tasks_.empty ()) {
+    poll (Timeout::max ());
+  }
+}
+
+void
+EventLoop::stop ()
+{
+  _pimpl->stopped_ = true;
+}
+
+EventLoop::Sleep
+EventLoop::sleep (const uint32_t timeout)
+{
+  return Sleep (timeout);
+}
+
+#endif // defined(XTOOLS_COROUTINES)
+
+using serial::VirtualPortPair;
+
+VirtualPortPair::VirtualPortPair ()
+  : _driver (-1), _port (-1)
+{
+  char name[256];
+  if (-1 == openpty (&_driver, &_port, name, NULL, NULL)) {
+    THROW (IOException, errno);
+  }
+  _name = name;
+
+  // Raw line until a Serial opens it and sets its own options.
+  struct termios options;
+  if (0 == tcgetattr (_port, &options)) {
+    cfmakeraw (&options);
+    tcsetattr (_port, TCSANOW, &options);
+  }
+}
+
+VirtualPortPair::~VirtualPortPair ()
+{
+  ::close (_driver);
+  ::close (_port);
+}
+
+const string
+VirtualPortPair::getPort () const
+{
+  return _name;
+}
+
+const int
+VirtualPortPair::getDriverFd () const
+{
+  return _driver;
+}
+
+const size_t
+VirtualPortPair::write (const uint8_t *data, const size_t size)
+{
+  size_t bytes_written = 0;
+  while (bytes_written < size) {
+    ssize_t bytes_written_now =
+      ::write (_driver, data + bytes_written, size - bytes_written);
+    if (bytes_written_now < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      THROW (IOException, errno);
+    }
+    bytes_written += static_cast<size_t> (bytes_written_now);
+  }
+  return bytes_written;
+}
+
+const size_t
+VirtualPortPair::write (const string &data)
+{
+  return write (reinterpret_cast<const uint8_t *> (data.data ()), data.size ());
+}
+
+const size_t
+VirtualPortPair::read (uint8_t *buffer, const size_t size,
+                       const uint32_t timeout)
+{
+  fd_set readfds;
+  FD_ZERO (&readfds);
+  FD_SET (_driver, &readfds);
+  timespec timeout_ts (timespec_from_ms (timeout));
+  int r = pselect (_driver + 1, &readfds, NULL, NULL, &timeout_ts, NULL);
+  if (r < 0) {
+    if (errno == EINTR) {
+      return 0;
+    }
+    THROW (IOException, errno);
+  }
+  if (r == 0) {
+    return 0;
+  }
+  ssize_t bytes_read = ::read (_driver, buffer, size);
+  if (bytes_read < 0) {
+    if (errno == EAGAIN || errno == EINTR) {
+      return 0;
+    }
+    THROW (IOException, errno);
+  }
+  return static_cast<size_t> (bytes_read);
+}
+
+const string
+VirtualPortPair::read (const size_t size, const uint32_t timeout)
+{
+  string buffer (size, '\0');
+  size_t bytes_read =
+    read (reinterpret_cast<uint8_t *> (&buffer[0]), size, timeout);
+  buffer.resize (bytes_read);
+  return buffer;
+}
+
+using serial::Journal;
+using serial::Replay;
+
+class Replay::ReplayImpl {
+public:
+  explicit ReplayImpl (const string &path, double speed)
+    : speed_ (speed), delay_ (0), started_ (false), joined_ (false),
+      stop_ (false), done_ (false)
+  {
+    journal_.open (path);
+    // Never block in write, so stop is seen while the reader stalls.
+    int flags = fcntl (pair_.getDriverFd (), F_GETFL, 0);
+    fcntl (pair_.getDriverFd (), F_SETFL, flags | O_NONBLOCK);
+  }
+
+  // stop_ and done_ cross between the caller and the replay thread.
+  bool
+  stopping () const
+  {
+    return __atomic_load_n (&stop_, __ATOMIC_ACQUIRE);
+  }
+
+  void
+  stop ()
+  {
+    __atomic_store_n (&stop_, true, __ATOMIC_RELEASE);
+  }
+
+  bool
+  finished () const
+  {
+    return __atomic_load_n (&done_, __ATOMIC_ACQUIRE);
+  }
+
+  static void *
+  run (void *impl)
+  {
+    static_cast<ReplayImpl *> (impl)->play ();
+    return NULL;
+  }
+
+  // Sleep until the CLOCK_MONOTONIC time at, in slices that see stop.
+  bool
+  sleepUntil (int64_t at)
+  {
+    int64_t left;
+    while (!stopping () && (left = at - Deadline::now ()) > 0) {
+      timespec ts (timespec_from_ns (std::min<int64_t> (left, 50 * NS_PER_MS)));
+      nanosleep (&ts, NULL);
+    }
+    return !stopping ();
+  }
+
+  // Drop what the reader wrote, so its writes never fill the line.
+  void
+  drain ()
+  {
+    uint8_t scratch[256];
+    while (::read (pair_.getDriverFd (), scratch, sizeof (scratch)) > 0) {
+    }
+  }
+
+  // Write all of data, waiting for the reader to make room.
+  bool
+  feed (const string &data)
+  {
+    const int fd = pair_.getDriverFd ();
+    size_t written = 0;
+    while (written < data.size () && !stopping ()) {
+      ssize_t n = ::write (fd, data.data () + written, data.size () - written);
+      if (n > 0) {
+        written += static_cast<size_t> (n);
+        continue;
+      }
+      if (n < 0 && errno != EAGAIN && errno != EINTR) {
+        return false;
+      }
+      drain ();
+      fd_set writefds;
+      FD_ZERO (&writefds);
+      FD_SET (fd, &writefds);
+      timespec ts (timespec_from_ms (50));
+      pselect (fd + 1, NULL, &writefds, NULL, &ts, NULL);
+    }
+    return !stopping ();
+  }
+
+  void
+  play ()
+  {
+    if (sleepUntil (Deadline::now () + delay_ * NS_PER_MS)) {
+      // Timing is kept against the start, sleeps never add up to drift.
+      const int64_t start = Deadline::now ();
+      int64_t offset_us = 0;
+      Journal::Record record;
+      while (!stopping () && journal_.next (record)) {
+        offset_us += static_cast<int64_t> (record.delay);
+        if (record.direction == Journal::sent) {
+          drain ();
+          continue;
+        }
+        if (speed_ > 0 &&
+            !sleepUntil (start + static_cast<int64_t> (offset_us * 1000 / speed_))) {
+          break;
+        }
+        if (!feed (record.data)) {
+          break;
+        }
+      }
+    }
+    __atomic_store_n (&done_, true, __ATOMIC_RELEASE);
+  }
+
+  VirtualPortPair pair_;
+  Journal journal_;
+  double speed_;
+  uint32_t delay_;
+  pthread_t thread_;
+  bool started_;
+  bool joined_;
+  bool stop_;
+  bool done_;
+};
+
+Replay::Replay (const string &path, const double speed)
+  : _pimpl (new ReplayImpl (path, speed))
+{
+}
+
+Replay::~Replay ()
+{
+  _pimpl->stop ();
+  wait ();
+  delete _pimpl;
+}
+
+const string
+Replay::getPort () const
+{
+  return _pimpl->pair_.getPort ();
+}
+
+const uint32_t
+Replay::getBaudrate () const
+{
+  return _pimpl->journal_.getBaudrate ();
+}
+
+void
+Replay::start (const uint32_t delay)
+{
+  if (_pimpl->started_) {
+    return;
+  }
+  _pimpl->delay_ = delay;
+  int ret = pthread_create (&_pimpl->thread_, NULL, ReplayImpl::run, _pimpl);
+  if (ret != 0) {
+    THROW (IOException, ret);
+  }
+  _pimpl->started_ = true;
+}
+
+const bool
+Replay::done () const
+{
+  return _pimpl->finished ();
+}
+
+void
+Replay::wait ()
+{
+  if (_pimpl->started_ && !_pimpl->joined_) {
+    pthread_join (_pimpl->thread_, NULL);
+    _pimpl->joined_ = true;
+  }
+}
+
 #endif // !defined(_WIN32)
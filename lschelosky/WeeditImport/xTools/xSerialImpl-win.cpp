@@ -25,9 +25,11 @@ using serial::bytesize_t;
 using serial::parity_t;
 using serial::stopbits_t;
 using serial::flowcontrol_t;
+using serial::transport_t;
 using serial::SerialException;
 using serial::PortNotOpenedException;
 using serial::IOException;
+using serial::Statistics;
 
 /* only for synchronize. */
 #include <iostream>
@@ -61,7 +63,10 @@ Serial::SerialImpl::SerialImpl (
    _parity        ( parity ),
    _bytesize      ( bytesize ),
    _stopbits      ( stopbits ),
-   _flowcontrol   ( flowcontrol )
+   _flowcontrol   ( flowcontrol ),
+   _transport     ( serial::transport_default ),
+   _low_latency   ( false ),
+   _latency_timer ( 0 )
 {
   _read_mutex = CreateMutex( NULL, false, NULL );
   _write_mutex = CreateMutex( NULL, false, NULL );
@@ -83,6 +88,8 @@ Serial::SerialImpl::open()
     throw invalid_argument( "Empty port is invalid." );
   if( _is_open )
     throw SerialException( "Serial port already open." );
+  if( _transport != transport_default )
+    throw invalid_argument( "Only the default transport is available on Windows." );
 
   // See: https://github.com/wjwwood/serial/issues/84
   wstring port_with_prefix( _prefix_port_if_needed( _port ) );
@@ -114,6 +121,7 @@ Serial::SerialImpl::open()
   }
 
   _is_open = true;
+  _errors = Statistics();
   reconfigurePort();
 }
 
@@ -385,6 +393,13 @@ Serial::SerialImpl::read( uint8_t *buf, const size_t size )
   return ( size_t )( bytes_read );
 }
 
+const size_t
+Serial::SerialImpl::readBatch( uint8_t *buf, const size_t size )
+{
+  /* No transport_streaming here, open refuses it. */
+  return read( buf, size );
+}
+
 const size_t
 Serial::SerialImpl::write( const uint8_t *data, const size_t length )
 {
@@ -497,6 +512,51 @@ Serial::SerialImpl::getFlowcontrol() const
   return _flowcontrol;
 }
 
+void
+Serial::SerialImpl::setTransport( const serial::transport_t transport )
+{
+  _transport = transport;
+}
+
+const serial::transport_t
+Serial::SerialImpl::getTransport() const
+{
+  return _transport;
+}
+
+void
+Serial::SerialImpl::setLowLatency( const bool low_latency )
+{
+  /* The Windows COM drivers have no such switch, the FTDI latency is
+   * set in the device manager. */
+  _low_latency = low_latency;
+}
+
+const bool
+Serial::SerialImpl::getLowLatency() const
+{
+  return _low_latency;
+}
+
+void
+Serial::SerialImpl::setLatencyTimer( const uint32_t millis )
+{
+  /* The FTDI VCP driver keeps its latency timer in the registry. */
+  _latency_timer = millis;
+}
+
+const uint32_t
+Serial::SerialImpl::getLatencyTimer() const
+{
+  return _latency_timer;
+}
+
+const uint32_t
+Serial::SerialImpl::getAdapterLatency() const
+{
+  return 0;
+}
+
 void
 Serial::SerialImpl::flush ()
 {
@@ -662,6 +722,35 @@ Serial::SerialImpl::getCD() const
   return ( MS_RLSD_ON & dwModemStatus ) != 0;
 }
 
+void
+Serial::SerialImpl::getErrorCounters( Statistics &stats )
+{
+  if( !_is_open )
+    return;
+
+  /* Windows only flags the errors seen since the last check. */
+  DWORD errors;
+  COMSTAT status;
+  if( ClearCommError( _hSerial, &errors, &status ) )
+  {
+    if( errors & CE_OVERRUN )
+      ++_errors.overrun;
+    if( errors & CE_FRAME )
+      ++_errors.frame;
+    if( errors & CE_RXPARITY )
+      ++_errors.parity;
+    if( errors & CE_BREAK )
+      ++_errors.brk;
+    if( errors & CE_RXOVER )
+      ++_errors.buf_overrun;
+  }
+  stats.overrun     = _errors.overrun;
+  stats.frame       = _errors.frame;
+  stats.parity      = _errors.parity;
+  stats.brk         = _errors.brk;
+  stats.buf_overrun = _errors.buf_overrun;
+}
+
 void
 Serial::SerialImpl::readLock()
 {
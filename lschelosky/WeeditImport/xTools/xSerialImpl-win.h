@@ -63,6 +63,9 @@ public:
   const size_t
     read( uint8_t *buf, const size_t size = 1 );
 
+  const size_t
+    readBatch( uint8_t *buf, const size_t size );
+
   const size_t
     write( const uint8_t *data, const size_t length );
 
@@ -108,6 +111,9 @@ public:
   const bool
     getCD() const;
 
+  void
+    getErrorCounters( Statistics &stats );
+
   void
     setPort( const string &port );
 
@@ -150,6 +156,27 @@ public:
   const flowcontrol_t
     getFlowcontrol() const;
 
+  void
+    setTransport( const transport_t transport );
+
+  const transport_t
+    getTransport() const;
+
+  void
+    setLowLatency( const bool low_latency );
+
+  const bool
+    getLowLatency() const;
+
+  void
+    setLatencyTimer( const uint32_t millis );
+
+  const uint32_t
+    getLatencyTimer() const;
+
+  const uint32_t
+    getAdapterLatency() const;
+
   void
     readLock();
 
@@ -175,6 +202,10 @@ private:
   bytesize_t      _bytesize;     /* Size of the bytes. */
   stopbits_t      _stopbits;     /* Stop Bits. */
   flowcontrol_t   _flowcontrol;  /* Flow Control. */
+  transport_t     _transport;    /* IO transport. */
+  bool            _low_latency;  /* Low-latency profile, stored only. */
+  uint32_t        _latency_timer;/* Adapter latency timer, stored only. */
+  Statistics      _errors;       /* ClearCommError checks per error. */
   Timeout         _timeout;      /* Timeout for read operations. */
 
   HANDLE          _read_mutex;   /* Mutex to lock the read functions. */
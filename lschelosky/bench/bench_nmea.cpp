@@ -0,0 +1,119 @@
+/*!
+** \file    bench_nmea.cpp
+** \date    2026/10/17 08:00
+** \brief   Time per line, the former split parse against tokenize.
+** \author  A.Godinho (Woody)
+**
+** any platform xCommons builds on, from a VS2008 command prompt:
+**    cl /EHsc /O2 /I..\WeatherImport\xTools bench_nmea.cpp
+**       ..\WeatherImport\xTools\xNmea.cpp ..\WeatherImport\xTools\xCommons.cpp
+**    bench_nmea [log=..\arduino-loopback\weatherstation.txt]
+**
+** The $WIMDA lines of the log are first parsed both ways and their fields
+** compared, then one line is parsed a million times each way.
+**/
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include "xCommons.h"
+#include "xNmea.h"
+
+//-----------------------------------------------------------------------------
+
+/* The WIMDA fields as parseNMEA used to get them, empty if none. */
+static
+const stringVector
+   splitWIMDA(
+      string line
+   )
+{
+   size_t pos;
+   while( ( pos = line.find( "\r" ) ) != string::npos )
+      line.erase( pos, 1 );
+   if( ( pos = line.find( "$$" ) ) != string::npos )
+      line.replace( pos, 2, "$" );
+
+   const stringVector SV( split( line, '$' ) );
+   if( SV.size() > 1 )
+   {
+      stringVector fields( split( SV[ 1 ], ',' ) );
+      if( !fields.empty() && fields[ 0 ] == "WIMDA" )
+         return fields;
+   }
+   return stringVector();
+}
+
+/* The same through nmeaSentence and tokenize. */
+static
+const bool
+   tokenizeWIMDA(
+      const string&  LINE,
+            nmeaFields& fields
+   )
+{
+   return tokenize( nmeaSentence( LINE ), fields ) && fields[ 0 ] == stringView( "WIMDA" );
+}
+
+static
+const bool
+   sameFields(
+      const string& LINE
+   )
+{
+   const stringVector OLD( splitWIMDA( LINE ) );
+   nmeaFields fields;
+   if( !tokenizeWIMDA( LINE, fields ) )
+      return OLD.empty();
+   if( OLD.size() != fields.size() )
+      return false;
+   for( size_t i( 0 ); i < OLD.size(); i ++ )
+      if( stringView( OLD[ i ] ) != fields[ i ] )
+         return false;
+   return true;
+}
+
+int main( int argc, char** argv )
+{
+   std::ifstream log( argc > 1 ? argv[ 1 ] : "../arduino-loopback/weatherstation.txt" );
+   string line;
+   int lines( 0 ), differ( 0 );
+   while( std::getline( log, line ) )
+   {
+      lines ++;
+      if( !sameFields( line + "\r" ) )
+      {
+         differ ++;
+         printf( "differ: %s\n", line.c_str() );
+      }
+   }
+   printf( "%d lines, %d differ\n", lines, differ );
+
+   const string LINE( "2016-08-27 10:20\t$WIMDA,30.2269,I,1.0236,B,13.8,C,,,45.9,,2.3,C,80.6,T,69.7,M,1.2,N,0.6,M*53\r" );
+   const int N( 1000000 );
+   size_t sink( 0 );
+
+   const ulong START( tickMillis() );
+   for( int i( 0 ); i < N; i ++ )
+   {
+      const stringVector SV( split( LINE, '$' ) );
+      const stringVector FIELDS( split( SV[ 1 ], ',' ) );
+      sink += FIELDS.size() + FIELDS[ 5 ].size();
+   }
+   const ulong SPLIT( tickMillis() - START );
+
+   for( int i( 0 ); i < N; i ++ )
+   {
+      nmeaFields fields;
+      tokenize( nmeaSentence( LINE ), fields );
+      sink += fields.size() + fields[ 5 ].size();
+   }
+   const ulong TOKENIZE( tickMillis() - START - SPLIT );
+
+   printf( "split x2  %7.1f ns/line\ntokenize  %7.1f ns/line\n(sink %lu)\n",
+      1e6 * SPLIT / N, 1e6 * TOKENIZE / N, ( ulong )sink );
+   return 0;
+}
+
+// EOF.
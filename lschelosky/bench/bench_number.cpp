@@ -0,0 +1,157 @@
+/*!
+** \file    bench_number.cpp
+** \date    2026/10/17 08:00
+** \brief   Time per field, stringTo through a stream against parseNumber.
+** \author  A.Godinho (Woody)
+**
+** any platform xCommons builds on, from a VS2008 command prompt:
+**    cl /EHsc /O2 /I..\WeatherImport\xTools bench_number.cpp
+**       ..\WeatherImport\xTools\xCommons.cpp
+**    bench_number
+**
+** streamNumber is the former stringTo. Both are first run over edge cases
+** and 2M random decimals for every parseNumber type, and must agree bit
+** for bit, then the WIMDA fields are converted 2M times each way.
+**/
+
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+
+#include "xCommons.h"
+
+//-----------------------------------------------------------------------------
+
+static int s_mismatches( 0 );
+
+/* Do the stream and parseNumber agree on STR. */
+template< typename T >
+   void
+      compare(
+         const string& STR
+      )
+      {
+         T a( T( -999 ) ), b( T( -999 ) );
+         const bool A( xTools::streamNumber( stringView( STR ), a ) );
+         const bool B( xTools::parseNumber( stringView( STR ), b ) );
+         if( A != B || ( A && memcmp( &a, &b, sizeof( T ) ) != 0 ) )
+         {
+            std::ostringstream os;
+            os.precision( 17 );
+            os << "differ: [" << STR << "] stream " << a << " parseNumber " << b;
+            puts( os.str().c_str() );
+            s_mismatches ++;
+         }
+      }
+
+static
+void
+   compareAll(
+      const string& STR
+   )
+{
+   compare< int >( STR );
+   compare< long >( STR );
+   compare< uint >( STR );
+   compare< ulong >( STR );
+   compare< float >( STR );
+   compare< double >( STR );
+}
+
+/* xorshift, the same decimals on every platform. */
+static
+const uint
+   next(
+      uint& state
+   )
+{
+   state ^= state << 13;
+   state ^= state >> 17;
+   state ^= state << 5;
+   return state;
+}
+
+/* [-]d{1,8}[.d{1,7}] */
+static
+const string
+   randomDecimal(
+      uint& state
+   )
+{
+   string s;
+   if( next( state ) % 3 == 0 )
+      s += '-';
+   for( uint n( 1 + next( state ) % 8 ); n; n -- )
+      s += char( '0' + next( state ) % 10 );
+   const uint FRACTION( next( state ) % 8 );
+   if( FRACTION )
+   {
+      s += '.';
+      for( uint n( FRACTION ); n; n -- )
+         s += char( '0' + next( state ) % 10 );
+   }
+   return s;
+}
+
+int main()
+{
+   const char* const EDGES[] =
+   {
+      "", "0", "-0", "-0.0", "1.0236", "30.2269", "-999", "12abc", "78.356.3",
+      " 42", "\t-7", ".5", "5.", "-.5", "-", ".", "+3", "abc", "1e3", "1.5E-2",
+      "2147483647", "2147483648", "-2147483648", "-2147483649", "4294967295",
+      "4294967296", "-1", "18446744073709551615", "99999999999999999999", "0x1A",
+      "00012", "1.00000000000000000000001", "123456789012345678", "0.1", "0.3",
+      "16777217", "9007199254740993", "1234567.891", "  ", "+", "nan", "inf",
+      "3.4028236e38"
+   };
+   for( size_t i( 0 ); i < sizeof( EDGES ) / sizeof( EDGES[ 0 ] ); i ++ )
+      compareAll( EDGES[ i ] );
+
+   uint state( 2463534242U );
+   for( int i( 0 ); i < 2000000; i ++ )
+      compareAll( randomDecimal( state ) );
+   printf( "%d mismatches\n", s_mismatches );
+
+   /* a WIMDA sentence, empty field included. */
+   const char* const FIELDS[] =
+   {
+      "30.2269", "1.0236", "13.8", "", "45.9", "2.3", "80.6", "69.7", "1.2", "0.6"
+   };
+   stringView views[ 10 ];
+   for( int i( 0 ); i < 10; i ++ )
+      views[ i ] = stringView( FIELDS[ i ] );
+
+   const int N( 2000000 );
+   double sink( 0 );
+   float f;
+   int n;
+
+   ulong start( tickMillis() );
+   for( int i( 0 ); i < N; i ++ )
+      sink += !views[ i % 10 ].empty() && xTools::streamNumber( views[ i % 10 ], f ) ? f : -999;
+   const ulong FLOAT_STREAM( tickMillis() - start );
+
+   start = tickMillis();
+   for( int i( 0 ); i < N; i ++ )
+      sink += stringTo< float >( views[ i % 10 ], -999 );
+   const ulong FLOAT_FAST( tickMillis() - start );
+
+   start = tickMillis();
+   for( int i( 0 ); i < N; i ++ )
+      sink += xTools::streamNumber( stringView( "100" ), n ) ? n : 0;
+   const ulong INT_STREAM( tickMillis() - start );
+
+   start = tickMillis();
+   for( int i( 0 ); i < N; i ++ )
+      sink += stringTo< int >( stringView( "100" ), 0 );
+   const ulong INT_FAST( tickMillis() - start );
+
+   printf( "float  stream %6.1f ns  parseNumber %6.1f ns\n"
+           "int    stream %6.1f ns  parseNumber %6.1f ns\n(sink %g)\n",
+      1e6 * FLOAT_STREAM / N, 1e6 * FLOAT_FAST / N,
+      1e6 * INT_STREAM / N, 1e6 * INT_FAST / N, sink );
+   return 0;
+}
+
+// EOF.
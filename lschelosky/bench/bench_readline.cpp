@@ -0,0 +1,174 @@
+/*!
+** \file    bench_readline.cpp
+** \date    2026/10/17 08:00
+** \brief   Syscalls per line, buffered readline against bytewise reads.
+** \author  A.Godinho (Woody)
+**
+** linux only, over a pseudo-terminal:
+**    g++ -O2 -I../WeatherImport/xTools bench_readline.cpp
+**       ../WeatherImport/xTools/xSerial.cpp
+**       ../WeatherImport/xTools/xSerialImpl-unix.cpp
+**       -ldl -lpthread -lutil
+**    ./a.out
+**
+** "bytewise" is the loop readline used to be: read one byte, compare
+** the tail against the EOL, repeat.
+**/
+
+#include "xSerial.h"
+
+#include <dlfcn.h>
+#include <pty.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <sys/select.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+
+//-----------------------------------------------------------------------------
+
+/* counted while a run is on. */
+static long s_read, s_pselect, s_ioctl;
+static bool s_counting( false );
+
+extern "C" ssize_t read( int fd, void* buf, size_t n )
+{
+   static ssize_t ( *real )( int, void*, size_t )(
+      ( ssize_t ( * )( int, void*, size_t ) )dlsym( RTLD_NEXT, "read" ) );
+   if( s_counting )
+      ++ s_read;
+   return real( fd, buf, n );
+}
+
+extern "C" int pselect( int n, fd_set* r, fd_set* w, fd_set* e,
+                        const struct timespec* t, const sigset_t* s )
+{
+   static int ( *real )( int, fd_set*, fd_set*, fd_set*, const struct timespec*, const sigset_t* )(
+      ( int ( * )( int, fd_set*, fd_set*, fd_set*, const struct timespec*, const sigset_t* ) )
+         dlsym( RTLD_NEXT, "pselect" ) );
+   if( s_counting )
+      ++ s_pselect;
+   return real( n, r, w, e, t, s );
+}
+
+extern "C" int ioctl( int fd, unsigned long request, ... )
+{
+   static int ( *real )( int, unsigned long, void* )(
+      ( int ( * )( int, unsigned long, void* ) )dlsym( RTLD_NEXT, "ioctl" ) );
+   va_list ap;
+   va_start( ap, request );
+   void* arg( va_arg( ap, void* ) );
+   va_end( ap );
+   if( s_counting )
+      ++ s_ioctl;
+   return real( fd, request, arg );
+}
+
+//-----------------------------------------------------------------------------
+
+static const char* const LINE =
+   "$WIMDA,30.2239,I,1.0235,B,13.8,C,,,45.9,,2.3,C,73.0,T,62.1,M,1.0,N,0.5,M*53\r";
+
+/* The device end of one run, the master side of a pty. */
+struct writerJob
+{
+   int   fd;
+   int   lines;
+   bool  paced;                     /* one line per write, 200 us apart. */
+};
+
+static void* writerRun( void* arg )
+{
+   const writerJob& JOB( *static_cast< writerJob* >( arg ) );
+   const size_t SIZE( strlen( LINE ) );
+   for( int i( 0 ); i < JOB.lines; i ++ )
+   {
+      for( size_t done( 0 ); done < SIZE; )
+      {
+         const ssize_t N( write( JOB.fd, LINE + done, SIZE - done ) );
+         if( N > 0 )
+            done += N;
+         else
+            usleep( 100 );
+      }
+      if( JOB.paced )
+         usleep( 200 );
+   }
+   return NULL;
+}
+
+/* the former readline: one byte per read. */
+static const std::string bytewise( serial::Serial& port, const size_t SIZE, const std::string& EOL )
+{
+   std::string line;
+   uint8_t c;
+   while( line.size() < SIZE && port.read( &c, 1 ) == 1 )
+   {
+      line += char( c );
+      if( line.size() >= EOL.size() &&
+          line.compare( line.size() - EOL.size(), EOL.size(), EOL ) == 0 )
+         break;
+   }
+   return line;
+}
+
+static const double nowMicros()
+{
+   struct timespec ts;
+   clock_gettime( CLOCK_MONOTONIC, &ts );
+   return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void run( const bool BYTEWISE, const bool PACED )
+{
+   int master, slave;
+   char name[ 64 ];
+   openpty( &master, &slave, name, NULL, NULL );
+   struct termios raw;
+   tcgetattr( slave, &raw );
+   cfmakeraw( &raw );
+   tcsetattr( slave, TCSANOW, &raw );
+   serial::Serial port( name, 4800, serial::Timeout::simpleTimeout( 1000 ) );
+
+   writerJob job = { master, PACED ? 2000 : 20000, PACED };
+   s_read = s_pselect = s_ioctl = 0;
+   s_counting = true;
+   pthread_t writer;
+   pthread_create( &writer, NULL, writerRun, &job );
+
+   const size_t SIZE( strlen( LINE ) );
+   const double START( nowMicros() );
+   int lines( 0 );
+   while( lines < job.lines )
+   {
+      const std::string L( BYTEWISE ? bytewise( port, 128, "\r" ) : port.readline( 128, "\r" ) );
+      if( L.size() != SIZE )
+         break;
+      lines ++;
+   }
+   const double MICROS( nowMicros() - START );
+   s_counting = false;
+   pthread_join( writer, NULL );
+   port.close();
+   close( slave );
+   close( master );
+
+   printf( "%-9s %-5s lines %5d  read %6.2f  pselect %6.2f  ioctl %6.2f  /line  %7.2f us/line\n",
+      BYTEWISE ? "bytewise" : "readline", PACED ? "paced" : "bulk", lines,
+      double( s_read ) / lines, double( s_pselect ) / lines, double( s_ioctl ) / lines,
+      MICROS / lines );
+}
+
+int main()
+{
+   for( int paced( 0 ); paced < 2; paced ++ )
+      for( int bytewise( 1 ); bytewise >= 0; bytewise -- )
+         run( bytewise != 0, paced != 0 );
+   return 0;
+}
+
+// EOF.
@@ -0,0 +1,159 @@
+/*!
+** \file    bench_stream.cpp
+** \date    2026/10/17 08:00
+** \brief   Syscalls and wakeups per minute, default against streaming.
+** \author  A.Godinho (Woody)
+**
+** linux only, a 4800 bps station over a pseudo-terminal:
+**    g++ -O2 -I../WeatherImport/xTools bench_stream.cpp
+**       ../WeatherImport/xTools/xSerial.cpp
+**       ../WeatherImport/xTools/xSerialImpl-unix.cpp
+**       ../WeatherImport/xTools/xScan.cpp -ldl -lutil
+**    ./a.out [seconds=10] [chunk=8] [period_ms=16]
+**
+** 8 bytes every 16 ms is what a USB adapter hands over, ./a.out 10 74 500
+** is one whole line every 500 ms. Wakeups are voluntary context switches.
+**/
+
+#include "xSerial.h"
+
+#include <dlfcn.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <sys/resource.h>
+#include <sys/select.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+
+//-----------------------------------------------------------------------------
+
+/* counted while a run is on. */
+static long s_read, s_pselect, s_ioctl, s_sleep;
+static bool s_counting( false );
+
+extern "C" ssize_t read( int fd, void* buf, size_t n )
+{
+   static ssize_t ( *real )( int, void*, size_t )(
+      ( ssize_t ( * )( int, void*, size_t ) )dlsym( RTLD_NEXT, "read" ) );
+   if( s_counting )
+      ++ s_read;
+   return real( fd, buf, n );
+}
+
+extern "C" int pselect( int n, fd_set* r, fd_set* w, fd_set* e,
+                        const struct timespec* t, const sigset_t* s )
+{
+   static int ( *real )( int, fd_set*, fd_set*, fd_set*, const struct timespec*, const sigset_t* )(
+      ( int ( * )( int, fd_set*, fd_set*, fd_set*, const struct timespec*, const sigset_t* ) )
+         dlsym( RTLD_NEXT, "pselect" ) );
+   if( s_counting )
+      ++ s_pselect;
+   return real( n, r, w, e, t, s );
+}
+
+extern "C" int ioctl( int fd, unsigned long request, ... )
+{
+   static int ( *real )( int, unsigned long, void* )(
+      ( int ( * )( int, unsigned long, void* ) )dlsym( RTLD_NEXT, "ioctl" ) );
+   va_list ap;
+   va_start( ap, request );
+   void* arg( va_arg( ap, void* ) );
+   va_end( ap );
+   if( s_counting )
+      ++ s_ioctl;
+   return real( fd, request, arg );
+}
+
+extern "C" int nanosleep( const struct timespec* req, struct timespec* rem )
+{
+   static int ( *real )( const struct timespec*, struct timespec* )(
+      ( int ( * )( const struct timespec*, struct timespec* ) )dlsym( RTLD_NEXT, "nanosleep" ) );
+   if( s_counting )
+      ++ s_sleep;
+   return real( req, rem );
+}
+
+//-----------------------------------------------------------------------------
+
+static const char* const LINE =
+   "$WIMDA,30.0790,I,1.0186,B,21.5,C,,,48.2,,10.1,C,,T,,M,2.1,N,1.1,M*2F\r\n";
+
+/* The device end, CHUNK bytes every PERIOD ms for SECONDS. */
+static void station( serial::VirtualPortPair& pair, const int SECONDS,
+                     const size_t CHUNK, const long PERIOD )
+{
+   const struct timespec GAP = { PERIOD / 1000, ( PERIOD % 1000 ) * 1000000 };
+   std::string pending;
+   for( const time_t END( time( NULL ) + SECONDS + 1 ); time( NULL ) < END; )
+   {
+      while( pending.size() < CHUNK )
+         pending += LINE;
+      pair.write( reinterpret_cast< const uint8_t* >( pending.data() ), CHUNK );
+      pending.erase( 0, CHUNK );
+      nanosleep( &GAP, NULL );
+   }
+}
+
+static void run( const serial::transport_t TRANSPORT, const int SECONDS,
+                 const size_t CHUNK, const long PERIOD )
+{
+   serial::VirtualPortPair pair;
+   const pid_t PID( fork() );
+   if( PID == 0 )
+   {
+      station( pair, SECONDS, CHUNK, PERIOD );
+      _exit( 0 );
+   }
+
+   serial::Serial port;
+   port.setPort( pair.getPort() );
+   port.setBaudrate( 4800 );
+   port.setTimeout( serial::Timeout::simpleTimeout( 1000 ) );
+   port.setTransport( TRANSPORT );
+   port.open();
+
+   struct rusage before, after;
+   getrusage( RUSAGE_THREAD, &before );
+   s_read = s_pselect = s_ioctl = s_sleep = 0;
+   s_counting = true;
+
+   long lines( 0 );
+   for( const time_t END( time( NULL ) + SECONDS ); time( NULL ) < END; )
+   {
+      const std::string L( port.readline( 128, "\r\n" ) );
+      if( L.size() > 2 && L.compare( L.size() - 2, 2, "\r\n" ) == 0 )
+         lines ++;
+   }
+
+   s_counting = false;
+   getrusage( RUSAGE_THREAD, &after );
+   port.close();
+   kill( PID, SIGTERM );
+   waitpid( PID, NULL, 0 );
+
+   const double PER_MIN( 60.0 / SECONDS );
+   const long CALLS( s_read + s_pselect + s_ioctl + s_sleep );
+   printf( "%-9s lines/min %5.0f  syscalls/min %6.0f (read %.0f pselect %.0f ioctl %.0f nanosleep %.0f)"
+           "  wakeups/min %5.0f  syscalls/line %.1f\n",
+      TRANSPORT == serial::transport_streaming ? "streaming" : "default",
+      lines * PER_MIN, CALLS * PER_MIN, s_read * PER_MIN, s_pselect * PER_MIN,
+      s_ioctl * PER_MIN, s_sleep * PER_MIN, ( after.ru_nvcsw - before.ru_nvcsw ) * PER_MIN,
+      lines ? double( CALLS ) / lines : 0.0 );
+}
+
+int main( int argc, char** argv )
+{
+   const int SECONDS( argc > 1 ? atoi( argv[ 1 ] ) : 10 );
+   const size_t CHUNK( argc > 2 ? atoi( argv[ 2 ] ) : 8 );
+   const long PERIOD( argc > 3 ? atol( argv[ 3 ] ) : 16 );
+
+   run( serial::transport_default, SECONDS, CHUNK, PERIOD );
+   run( serial::transport_streaming, SECONDS, CHUNK, PERIOD );
+   return 0;
+}
+
+// EOF.
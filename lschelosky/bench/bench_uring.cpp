@@ -0,0 +1,125 @@
+/*!
+** \file    bench_uring.cpp
+** \date    2026/10/17 08:00
+** \brief   Lines per second and cpu per line, select against io_uring.
+** \author  A.Godinho (Woody)
+**
+** linux only, over a pseudo-terminal at 115200 bps:
+**    g++ -O2 -DUSE_IO_URING -I../WeatherImport/xTools bench_uring.cpp
+**       ../WeatherImport/xTools/xSerial.cpp
+**       ../WeatherImport/xTools/xSerialImpl-unix.cpp
+**       -lpthread -lutil
+**    ./a.out
+**
+** cpu is process time, the writer thread included.
+**/
+
+#include "xSerial.h"
+
+#include <pthread.h>
+#include <pty.h>
+#include <sys/resource.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+
+//-----------------------------------------------------------------------------
+
+static const char* const LINE =
+   "$WIMDA,30.2239,I,1.0235,B,13.8,C,,,45.9,,2.3,C,73.0,T,62.1,M,1.0,N,0.5,M*53\r";
+
+/* The device end of one run, the master side of a pty. */
+struct writerJob
+{
+   int   fd;
+   int   lines;
+   bool  paced;                     /* one line per ms. */
+};
+
+static void* writerRun( void* arg )
+{
+   const writerJob& JOB( *static_cast< writerJob* >( arg ) );
+   const size_t SIZE( strlen( LINE ) );
+   for( int i( 0 ); i < JOB.lines; i ++ )
+   {
+      for( size_t done( 0 ); done < SIZE; )
+      {
+         const ssize_t N( write( JOB.fd, LINE + done, SIZE - done ) );
+         if( N > 0 )
+            done += N;
+         else
+            usleep( 100 );
+      }
+      if( JOB.paced )
+         usleep( 1000 );
+   }
+   return NULL;
+}
+
+static const double cpuSeconds()
+{
+   struct rusage ru;
+   getrusage( RUSAGE_SELF, &ru );
+   return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec +
+          ( ru.ru_utime.tv_usec + ru.ru_stime.tv_usec ) / 1e6;
+}
+
+static const double nowSeconds()
+{
+   struct timespec ts;
+   clock_gettime( CLOCK_MONOTONIC, &ts );
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void run( const serial::transport_t TRANSPORT, const bool PACED )
+{
+   int master, slave;
+   char name[ 64 ];
+   openpty( &master, &slave, name, NULL, NULL );
+   struct termios raw;
+   tcgetattr( slave, &raw );
+   cfmakeraw( &raw );
+   tcsetattr( slave, TCSANOW, &raw );
+   serial::Serial port;
+   port.setPort( name );
+   port.setBaudrate( 115200 );
+   port.setTimeout( serial::Timeout::simpleTimeout( 1000 ) );
+   port.setTransport( TRANSPORT );
+   port.open();
+
+   writerJob job = { master, PACED ? 3000 : 200000, PACED };
+   const double CPU( cpuSeconds() );
+   const double START( nowSeconds() );
+   pthread_t writer;
+   pthread_create( &writer, NULL, writerRun, &job );
+
+   const size_t SIZE( strlen( LINE ) );
+   int lines( 0 );
+   while( lines < job.lines && port.readline( 128, "\r" ).size() == SIZE )
+      lines ++;
+   const double SECONDS( nowSeconds() - START );
+   const double CPU_USED( cpuSeconds() - CPU );
+   pthread_join( writer, NULL );
+   port.close();
+   close( slave );
+   close( master );
+
+   printf( "%-8s %-5s lines %6d  %7.0f lines/s  %5.1f us/line  %5.1f us cpu/line\n",
+      TRANSPORT == serial::transport_io_uring ? "io_uring" : "select", PACED ? "paced" : "bulk",
+      lines, lines / SECONDS, 1e6 * SECONDS / lines, 1e6 * CPU_USED / lines );
+}
+
+int main()
+{
+   for( int paced( 0 ); paced < 2; paced ++ )
+   {
+      run( serial::transport_default, paced != 0 );
+      run( serial::transport_io_uring, paced != 0 );
+   }
+   return 0;
+}
+
+// EOF.